@@ -0,0 +1,169 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2018 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#include "c74_min.h"
+#include "../shared/level_detector.h"
+#include <array>
+
+using namespace c74::min;
+using namespace c74::min::ui;
+
+
+class mc_meter : public object<mc_meter>, public ui_operator<140, 96>, public mc_operator<> {
+public:
+    MIN_DESCRIPTION	{ "Show the audio gain levels of every channel of a multi-channel signal. "
+                      "[mc.min.meter~] measures all of the channels together and draws them as a bridge of bars "
+                      "with a single timer and a single paint." };
+    MIN_TAGS		{ "ui" };
+    MIN_AUTHOR		{ "Cycling '74" };
+    MIN_RELATED		{ "min.meter~, mc.meter~, meter~" };
+
+    inlet<>  input	{ this, "(multichannelsignal) audio to measure / visualize" };
+    outlet<> output	{ this, "(list) level of each channel" };
+
+    mc_meter(const atoms& args = {})
+    : ui_operator::ui_operator {this, args} {
+        m_timer.delay(40);
+    }
+
+    attribute<numbers> m_range			{ this, "range", { {0.0, 1.0}} };
+	attribute<color>   m_bgcolor {this, "bgcolor", color::predefined::black, title {"Background Color"}};
+	attribute<color>   m_elementcolor {this, "elementcolor", color::predefined::white};
+
+    enum class modes : int { peak, rms, enum_count };
+
+    enum_map mode_range = {"peak", "rms"};
+
+    attribute<modes> m_mode { this, "mode", modes::peak, mode_range,
+        description {"Level that is displayed and output: the peak amplitude or the RMS (average power)."}
+    };
+
+    attribute<number, threadsafe::yes, limit::clamp> m_attack { this, "attack", 0.0,
+        range {0.0, 10000.0},
+        description {"Time in ms for the meters to rise to a louder level."}
+    };
+
+    attribute<number, threadsafe::yes, limit::clamp> m_release { this, "release", 300.0,
+        range {0.0, 10000.0},
+        description {"Time in ms for the meters to fall to a quieter level."}
+    };
+
+    // All of the channels are drawn as horizontal bars stacked from top to bottom.
+
+    message<> paint { this, "paint",
+        MIN_FUNCTION {
+            target t {args};
+            auto   channels = m_channels.load();
+            auto   bar      = (t.height() - 2.0) / std::max(channels, 1);
+
+            m_width = t.width();
+
+            rect<fill> {// background
+                t,
+                color {m_bgcolor}
+            };
+            rect<> {// frame
+                t,
+                color {{0.3, 0.3, 0.3, 1.0}},
+                line_width {3.0}
+            };
+            for (auto channel = 0; channel < channels; ++channel) {
+                auto length = pixel_for(m_values[channel], t.width());
+
+                rect<fill> {// active part of this channel's bar, with a gap between the bars when there is room
+                    t,
+                    color {m_elementcolor},
+                    position {1.0, 1.0 + channel * bar},
+                    size {length, bar > 3.0 ? bar - 1.0 : bar}
+                };
+                m_drawn[channel] = length;
+            }
+            m_drawn_channels = channels;
+            return {};
+        }
+    };
+
+    // A single timer serves every channel.
+    // The bridge is only redrawn, and the levels only output, when at least one bar would move by a pixel.
+
+    timer<timer_options::defer_delivery> m_timer { this,
+        MIN_FUNCTION {
+            auto channels = m_channels.load();
+            auto rms      = (m_mode == modes::rms);
+            auto moved    = (channels != m_drawn_channels);
+
+            for (auto channel = 0; channel < channels; ++channel) {
+                auto level = (rms ? m_rms[channel] : m_peak[channel]).load(std::memory_order_relaxed);
+
+                m_values[channel] = level;
+                if (std::abs(pixel_for(level, m_width) - m_drawn[channel]) >= 1.0)
+                    moved = true;
+            }
+
+            if (moved) {
+                atoms levels(m_values.begin(), m_values.begin() + channels);
+
+                redraw();
+                output.send(levels);
+            }
+            m_timer.delay(40);
+            return {};
+        }
+    };
+
+    // Every channel is measured in the same pass, keeping the state for all of them in contiguous arrays.
+
+    void operator()(audio_bundle input, audio_bundle output) {
+        auto channels      = std::min<int>(input.channel_count(), k_max_channels);
+        auto frames        = input.frame_count();
+        auto vector_ms     = frames / samplerate() * 1000.0;
+        auto attack_coeff  = level_detector::coefficient(vector_ms, m_attack);
+        auto release_coeff = level_detector::coefficient(vector_ms, m_release);
+
+        for (auto channel = 0; channel < channels; ++channel) {
+            double peak, rms;
+
+            level_detector::measure(input.samples(channel), frames, peak, rms);
+            m_peak_envelopes[channel] = level_detector::follow(m_peak_envelopes[channel], peak, attack_coeff, release_coeff);
+            m_rms_envelopes[channel]  = level_detector::follow(m_rms_envelopes[channel], rms, attack_coeff, release_coeff);
+            m_peak[channel].store(m_peak_envelopes[channel], std::memory_order_relaxed);
+            m_rms[channel].store(m_rms_envelopes[channel], std::memory_order_relaxed);
+        }
+        m_channels.store(channels);
+    }
+
+private:
+    static constexpr int k_max_channels { 1024 };    ///< the most channels a multi-channel signal can carry
+
+    template<class T>
+    using per_channel = std::array<T, k_max_channels>;
+
+    // owned by the audio thread
+
+    per_channel<double> m_peak_envelopes {};
+    per_channel<double> m_rms_envelopes {};
+
+    // written by the audio thread and read by the timer
+
+    per_channel<std::atomic<float>> m_peak {};
+    per_channel<std::atomic<float>> m_rms {};
+    std::atomic<int>                m_channels { 0 };
+
+    // owned by the main thread
+
+    per_channel<number> m_values {};
+    per_channel<number> m_drawn {};             ///< bar lengths when the bridge was last painted
+    int                 m_drawn_channels { -1 };
+    number              m_width { 140.0 };       ///< width of the bridge when it was last painted
+
+    // the length of the bar for a value: one pixel for each border and -1 for counting to N-1
+
+    number pixel_for(number value, number width) {
+        auto normalized = (MIN_CLAMP(value, m_range[0], m_range[1]) - m_range[0]) / (m_range[1] - m_range[0]);
+        return ((width - 3) * normalized) + 1;
+    }
+};
+
+MIN_EXTERNAL(mc_meter);
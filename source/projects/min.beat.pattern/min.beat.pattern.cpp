@@ -4,11 +4,129 @@
 ///	@license	Use of this source code is governed by the MIT License found in the License.md file.
 
 #include "c74_min.h"
+#include "../shared/beat_clock.h"
 
 using namespace c74::min;
 
 
-class beat_pattern : public object<beat_pattern> {
+// Convert an entry of a pattern to ticks.
+// Numbers are taken as ticks while symbols are note values (e.g. 4n for a quarter note, 8nd for a dotted eighth note,
+// or 16nt for a sixteenth-note triplet) which are converted using Max's resolution of 480 ticks per quarter note.
+
+double ticks_from_atom(const atom& a) {
+    if (a.a_type != c74::max::A_SYM)
+        return a;
+
+    symbol      s     = a;
+    const char* str   = s.c_str();
+    char*       end   = nullptr;
+    auto        value = std::strtol(str, &end, 10);
+
+    if (value <= 0 || *end != 'n')
+        throw std::invalid_argument(string("invalid note value: ") + str);
+
+    double ticks = 1920.0 / value;    // a whole note
+
+    ++end;
+    if (*end == 'd')
+        ticks *= 1.5;
+    else if (*end == 't')
+        ticks *= 2.0 / 3.0;
+    else if (*end != 0)
+        throw std::invalid_argument(string("invalid note value: ") + str);
+    return ticks;
+}
+
+
+// A pattern of durations compiled to contiguous arrays of doubles.
+// The offset of each step from the start of the pattern is also calculated so that any position
+// can be located in the pattern with a binary search rather than by stepping through it.
+//
+// A compiled_pattern is never modified once it has been created.
+// This allows a new pattern to be prepared (and allocated) on the main thread and then handed to the scheduler
+// by swapping a pointer.
+
+class compiled_pattern {
+public:
+    struct position {
+        double start;    ///< absolute position at which this step begins
+        size_t index;    ///< step within the pattern
+    };
+
+    /// Compile and validate a pattern.
+    /// @param	sequence			The durations of the steps.
+    /// @param	allow_note_values	True if note values (which are converted to ticks) are permitted.
+    compiled_pattern(const atoms& sequence, bool allow_note_values) {
+        if (sequence.empty())
+            throw std::invalid_argument("pattern is empty");
+
+        m_durations.reserve(sequence.size());
+        m_offsets.reserve(sequence.size());
+
+        for (const auto& a : sequence) {
+            if (a.a_type == c74::max::A_SYM && !allow_note_values)
+                throw std::invalid_argument("note values in a pattern require the units to be set to ticks");
+
+            auto duration = ticks_from_atom(a);
+
+            if (!(duration > 0.0))
+                throw std::invalid_argument("pattern durations must be greater than zero");
+            m_offsets.push_back(m_length);
+            m_durations.push_back(duration);
+            m_length += duration;
+        }
+    }
+
+    size_t size() const {
+        return m_durations.size();
+    }
+
+    /// The first step starting at or after a position.
+    /// @param	at		The position to locate.
+    /// @param	origin	The position at which the pattern (or one of its repetitions) started.
+    position seek(double at, double origin) const {
+        auto cycle_start = origin + std::floor((at - origin) / m_length) * m_length;
+        auto index       = static_cast<size_t>(std::lower_bound(m_offsets.begin(), m_offsets.end(), at - cycle_start) - m_offsets.begin());
+
+        if (index == size())
+            return {cycle_start + m_length, 0};
+        return {cycle_start + m_offsets[index], index};
+    }
+
+    /// The step following another step.
+    position next(position p) const {
+        auto start = p.start + m_durations[p.index];
+
+        if (++p.index == size())
+            return {start, 0};
+        return {start, p.index};
+    }
+
+    /// The position at which the repetition of the pattern containing a step ends.
+    double cycle_end(position p) const {
+        return p.start - m_offsets[p.index] + m_length;
+    }
+
+    /// The duration of a step.
+    double duration(size_t index) const {
+        return m_durations[index];
+    }
+
+private:
+    std::vector<double> m_durations;
+    std::vector<double> m_offsets;
+    double              m_length {};
+};
+
+
+class beat_pattern : public object<beat_pattern>, public vector_operator<> {
+private:
+    // these must be declared before the attributes whose setters use them
+
+    absolute_schedule m_schedule;    ///< target times for the drift-free mode
+    click_generator   m_clicks;      ///< sample-accurate rendering of the beats
+    std::atomic<bool> m_restarted { false };    ///< the timer has been turned on, so the timer thread must find its place again
+
 public:
     MIN_DESCRIPTION	{ "Bang at intervals in a repeating pattern." };
     MIN_TAGS		{ "time" };
@@ -18,20 +136,20 @@ public:
     inlet<>  input			{ this, "(toggle) on/off" };
     outlet<> bang_out		{ this, "(bang) triggers at according to specified pattern" };
     outlet<> interval_out	{ this, "(float) the interval for the current bang" };
+    outlet<> click_out		{ this, "(signal) click at the exact sample of each bang", "signal" };
 
-    timer<> metro { this,
-        MIN_FUNCTION {
-            double interval = m_sequence[m_index];
-
-            interval_out.send(interval);
-            bang_out.send("bang");
+    ~beat_pattern() {
+        delete m_pending.exchange(nullptr);
+        collect_retired();
+    }
 
-            metro.delay(interval);
-
-            m_index += 1;
 
-            if (m_index == m_sequence.size())
-              m_index = 0;
+    timer<> metro { this,
+        MIN_FUNCTION {
+            if (units == unit::ticks)
+                step_transport();
+            else
+                step();
             return {};
         }
     };
@@ -39,14 +157,50 @@ public:
     attribute<bool> on {this, "on", false,
         description {"Turn on/off the internal timer."},
         setter { MIN_FUNCTION {
-            if (args[0] == true)
+            if (args[0] == true) {
+                m_schedule.start();
+                m_restarted = true;
                 metro.delay(0.0);    // fire the first one straight-away
-            else
+            }
+            else {
                 metro.stop();
+                m_clicks.stop();
+            }
             return args;
         }}
     };
 
+    attribute<bool> drift_free { this, "drift_free", false,
+        description {"Schedule each bang relative to when the previous bang was due rather than when it actually happened. "
+                     "This prevents the lateness of the scheduler from accumulating so the pattern does not drift over time."}
+    };
+
+    // The units of the durations in the pattern.
+    // In 'ticks' mode the pattern follows the global transport: steps fall on fixed positions of the timeline,
+    // tempo changes are tracked, and relocating the transport jumps straight to the matching step.
+
+    enum class unit : int { ms, ticks, enum_count };
+
+    enum_map unit_range = {"ms", "ticks"};
+
+    attribute<unit> units { this, "units", unit::ms, unit_range,
+        description {"Units of the durations in the pattern. "
+                     "In 'ticks' mode the pattern is locked to the global transport and may also contain note values such as 4n, 8nd, or 16nt."}
+    };
+
+    // When a new pattern arrives while the timer is running it can take over straight away
+    // or wait until the current pattern (or, when following the transport, the current bar) is complete.
+
+    enum class swap_point : int { immediate, pattern, bar, enum_count };
+
+    enum_map swap_point_range = {"immediate", "pattern", "bar"};
+
+    attribute<swap_point> swap { this, "swap", swap_point::immediate, swap_point_range,
+        description {"When a new pattern replaces the one that is playing. "
+                     "'pattern' waits for the current pattern to complete and 'bar' waits for the next bar line of the transport "
+                     "(in ms units 'bar' is the same as 'pattern')."}
+    };
+
     message<> toggle { this, "int", "Turn on/off the internal timer.",
         MIN_FUNCTION {
             on = args[0];
@@ -57,16 +211,191 @@ public:
 
     message<> dictionary { this, "dictionary", "Use a dictionary to define the pattern of bangs produced.",
         MIN_FUNCTION {
-            dict d {args[0]};
+            dict  d {args[0]};
+            atoms sequence = d["pattern"];
+
+            try {
+                auto fresh = new compiled_pattern {sequence, units == unit::ticks};
+
+                // if a pattern is still waiting to be picked up by the scheduler then it was never played and we can free it
 
-            m_sequence = d["pattern"];
+                delete m_pending.exchange(fresh);
+                collect_retired();
+            }
+            catch (std::exception& e) {
+                cerr << e.what() << endl;
+            }
             return {};
         }
     };
 
+    message<> dspsetup { this, "dspsetup",
+        MIN_FUNCTION {
+            m_clicks.restart();
+            return {};
+        }
+    };
+
+    void operator()(audio_bundle input, audio_bundle output) {
+        m_clicks(output.samples(0), output.frame_count(), samplerate());
+    }
+
 private:
-    int   m_index		{ 0 };
-    atoms m_sequence	{ 250.0, 250.0, 250.0, 250.0, 500.0, 500.0, 500.0, 500.0 };
+    // The pattern is owned by the scheduler thread.
+    // New patterns are handed over through m_pending and replaced patterns are handed back through m_retired
+    // so that allocation and deallocation only ever happen on the main thread.
+
+    std::unique_ptr<const compiled_pattern>	m_pattern		{ std::make_unique<compiled_pattern>(atoms {250.0, 250.0, 250.0, 250.0, 500.0, 500.0, 500.0, 500.0}, false) };
+    std::atomic<const compiled_pattern*>	m_pending		{ nullptr };
+    fifo<const compiled_pattern*>			m_retired		{ 16 };
+    size_t									m_index			{ 0 };
+
+    compiled_pattern::position				m_next			{ 0.0, 0 };		///< the next step to play when following the transport
+    bool									m_located		{ false };		///< m_next is valid (only used on the scheduler thread)
+    double									m_last_ticks	{ 0.0 };
+    double									m_origin		{ 0.0 };		///< transport position at which the current pattern was started
+    double									m_swap_at		{ -1.0 };		///< transport position at which the pending pattern takes over
+
+    static constexpr double k_poll_interval	{ 20.0 };    ///< ms between checks of a stopped transport
+    static constexpr double k_max_wait		{ 20.0 };    ///< longest ms to wait before checking for tempo changes
+    static constexpr double k_max_late		{ 100.0 };   ///< ms past a step's time beyond which the transport must have jumped
+
+
+    void collect_retired() {
+        const compiled_pattern* retired;
+        while (m_retired.try_dequeue(retired))
+            delete retired;
+    }
+
+
+    // Replace the playing pattern with the pending one.
+    // Called on the scheduler thread.
+
+    bool take_pending() {
+        if (!m_pending.load())
+            return false;
+        if (!m_retired.try_enqueue(m_pattern.get()))
+            return false;    // the main thread has fallen behind collecting patterns, try again on the next step
+
+        // only this thread removes a pending pattern so it cannot have disappeared since we checked
+        m_pattern.release();
+        m_pattern.reset(m_pending.exchange(nullptr));
+        return true;
+    }
+
+
+    void beat(double interval) {
+        interval_out.send(interval);
+        bang_out.send("bang");
+        m_clicks.beat(interval);
+    }
+
+
+    void step() {
+        // the pattern may have been replaced while following the transport, leaving the index beyond its end
+
+        if (m_index >= m_pattern->size())
+            m_index = 0;
+
+        if (m_pending.load() && (m_index == 0 || swap == swap_point::immediate)) {
+            if (take_pending())
+                m_index = 0;
+        }
+
+        double interval = m_pattern->duration(m_index);
+
+        beat(interval);
+        if (drift_free)
+            metro.delay(m_schedule.advance(interval));
+        else
+            metro.delay(interval);
+
+        m_index += 1;
+
+        if (m_index == m_pattern->size())
+          m_index = 0;
+    }
+
+
+    void locate(compiled_pattern::position p) {
+        m_next    = p;
+        m_located = true;
+    }
+
+
+    // Calculate where a pending pattern should take over from the one that is playing.
+
+    double swap_position(c74::max::t_itm* itm, double now) {
+        if (swap == swap_point::immediate)
+            return now;
+        if (swap == swap_point::bar) {
+            long numerator {4};
+            long denominator {4};
+
+            c74::max::itm_gettimesignature(itm, &numerator, &denominator);
+
+            auto bar_length = numerator * 1920.0 / denominator;
+            return std::ceil(now / bar_length) * bar_length;
+        }
+        return m_located ? m_pattern->cycle_end(m_next) : now;
+    }
+
+
+    void step_transport() {
+        auto itm = static_cast<c74::max::t_itm*>(c74::max::itm_getglobal());
+
+        if (m_restarted.exchange(false))
+            m_located = false;
+
+        if (!c74::max::itm_getstate(itm)) {
+            m_located = false;
+            metro.delay(k_poll_interval);
+            return;
+        }
+
+        auto now = c74::max::itm_getticks(itm);
+
+        // If the transport moved backwards, or is so far past the time of the next step that it cannot just be the scheduler
+        // running late, it was relocated so we find our place in the pattern again rather than stepping through it.
+        // Steps that are merely late (even ones shorter than the lateness) are still played.
+
+        if (!m_located || now < m_last_ticks || now - m_next.start > c74::max::itm_mstoticks(itm, k_max_late))
+            locate(m_pattern->seek(now, m_origin));
+        m_last_ticks = now;
+
+        if (m_swap_at < 0.0 && m_pending.load())
+            m_swap_at = swap_position(itm, now);
+
+        for (;;) {
+            if (m_swap_at >= 0.0 && m_swap_at <= now) {
+                if (take_pending()) {
+                    m_index  = 0;
+                    m_origin = m_swap_at;
+                    locate({m_origin, 0});
+                }
+                m_swap_at = -1.0;
+            }
+
+            auto step = m_next;
+
+            if (step.start > now || (m_swap_at >= 0.0 && step.start >= m_swap_at))
+                break;
+
+            m_next = m_pattern->next(step);
+            beat(c74::max::itm_tickstoms(itm, m_pattern->duration(step.index)));
+        }
+
+        // The tempo may change before the next step so we convert to ms as late as possible
+        // and never wait so long that a tempo change would go unnoticed.
+
+        auto next = m_next.start;
+
+        if (m_swap_at >= 0.0)
+            next = std::min(next, m_swap_at);
+
+        auto wait = c74::max::itm_tickstoms(itm, next - now);
+        metro.delay(std::min(wait, k_max_wait));
+    }
 };
 
 MIN_EXTERNAL(beat_pattern);
@@ -0,0 +1,155 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2018 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+
+/// The xoshiro256** pseudo-random number generator by David Blackman and Sebastiano Vigna.
+/// It is small, fast, and statistically robust.
+/// Each instance owns its complete state so that many instances can generate independent streams without sharing a lock.
+
+class xoshiro256 {
+public:
+	explicit xoshiro256(std::uint64_t seed = 0) {
+		this->seed(seed);
+	}
+
+	/// Reset the state.
+	/// The seed is expanded using splitmix64 as recommended by the authors so that even similar seeds produce unrelated streams.
+	void seed(std::uint64_t seed) {
+		for (auto& s : m_state) {
+			seed += 0x9e3779b97f4a7c15;
+
+			auto z = seed;
+			z      = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+			z      = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+			s      = z ^ (z >> 31);
+		}
+	}
+
+	std::uint64_t operator()() {
+		auto result = rotl(m_state[1] * 5, 7) * 9;
+		auto t      = m_state[1] << 17;
+
+		m_state[2] ^= m_state[0];
+		m_state[3] ^= m_state[1];
+		m_state[1] ^= m_state[2];
+		m_state[0] ^= m_state[3];
+		m_state[2] ^= t;
+		m_state[3] = rotl(m_state[3], 45);
+		return result;
+	}
+
+	/// A uniformly distributed value in the range [0, 1).
+	double uniform() {
+		return static_cast<double>((*this)() >> 11) * (1.0 / 9007199254740992.0);    // 53 bits of mantissa
+	}
+
+private:
+	std::uint64_t m_state[4];
+
+	static std::uint64_t rotl(std::uint64_t x, int k) {
+		return (x << k) | (x >> (64 - k));
+	}
+};
+
+
+/// Generates random time intervals within a range using one of several distributions.
+
+class interval_generator {
+public:
+	enum class distributions : int {
+		uniform,        ///< every interval in the range is equally likely
+		gaussian,       ///< intervals cluster around the center of the range
+		exponential,    ///< the intervals of a Poisson process, which sound like natural, independent events
+		euler,          ///< a low-discrepancy sequence that spreads the intervals evenly over the range
+		enum_count
+	};
+
+	interval_generator() {
+		seed(0);
+	}
+
+	/// Seed the generator.
+	/// @param	seed	A seed of zero seeds the generator from the system's entropy source so every instance is different.
+	void seed(std::uint64_t seed) {
+		if (seed == 0) {
+			std::random_device device;
+			seed = (static_cast<std::uint64_t>(device()) << 32) | device();
+		}
+		m_generator.seed(seed);
+		m_sequence  = m_generator.uniform();
+		m_has_spare = false;
+	}
+
+	/// Generate the next interval.
+	/// @param	distribution	The distribution from which to draw.
+	/// @param	low				The lower bound of the range.
+	/// @param	high			The upper bound of the range.
+	double operator()(distributions distribution, double low, double high) {
+		auto range = high - low;
+
+		switch (distribution) {
+			case distributions::gaussian: {
+				// centered in the range with three standard deviations to either side
+				auto value = (low + high) * 0.5 + normal() * range / 6.0;
+				return std::min(std::max(value, std::min(low, high)), std::max(low, high));
+			}
+			case distributions::exponential: {
+				// an exponential distribution with a mean of half the range, truncated to the range by inverting its CDF
+				if (range <= 0.0)
+					return low;
+
+				auto scale = range * 0.5;
+				auto u     = m_generator.uniform();
+				return low - scale * std::log(1.0 - u * (1.0 - std::exp(-range / scale)));
+			}
+			case distributions::euler:
+				// the additive recurrence x[n+1] = x[n] + 1/e (mod 1) from a random starting point
+				m_sequence += 0.36787944117144233;
+				if (m_sequence >= 1.0)
+					m_sequence -= 1.0;
+				return low + m_sequence * range;
+			case distributions::uniform:
+			case distributions::enum_count:
+				break;
+		}
+		return low + m_generator.uniform() * range;
+	}
+
+private:
+	xoshiro256 m_generator;
+	double     m_sequence {};
+	double     m_spare {};
+	bool       m_has_spare {};
+
+	// A standard normal deviate using the polar form of the Box-Muller transform.
+	// Each transform produces two deviates so we keep the second for the next call.
+
+	double normal() {
+		if (m_has_spare) {
+			m_has_spare = false;
+			return m_spare;
+		}
+
+		double u, v, s;
+		do {
+			u = m_generator.uniform() * 2.0 - 1.0;
+			v = m_generator.uniform() * 2.0 - 1.0;
+			s = u * u + v * v;
+		} while (s >= 1.0 || s == 0.0);
+
+		auto factor = std::sqrt(-2.0 * std::log(s) / s);
+
+		m_spare     = v * factor;
+		m_has_spare = true;
+		return u * factor;
+	}
+};
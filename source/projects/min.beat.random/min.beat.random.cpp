@@ -4,11 +4,20 @@
 ///	@license	Use of this source code is governed by the MIT License found in the License.md file.
 
 #include "c74_min.h"
+#include "../shared/beat_clock.h"
+#include "interval_generator.h"
 
 using namespace c74::min;
 
 
-class beat_random : public object<beat_random> {
+class beat_random : public object<beat_random>, public vector_operator<> {
+private:
+    // these must be declared before the attributes whose setters use them
+
+    absolute_schedule  m_schedule;     ///< target times for the drift-free mode
+    click_generator    m_clicks;       ///< sample-accurate rendering of the beats
+    interval_generator m_generator;    ///< this instance's own random number stream
+
 public:
     MIN_DESCRIPTION	{ "Bang at random intervals." };
     MIN_TAGS		{ "time" };
@@ -18,6 +27,7 @@ public:
     inlet<>  input			{ this, "(toggle) on/off" };
     outlet<> bang_out		{ this, "(bang) triggers at randomized interval" };
     outlet<> interval_out	{ this, "(float) the interval for the current bang" };
+    outlet<> click_out		{ this, "(signal) click at the exact sample of each bang", "signal" };
 
     argument<number> minimum_arg { this, "minimum", "Initial lower-bound of generated random interval.",
         MIN_ARGUMENT_FUNCTION {
@@ -33,12 +43,16 @@ public:
 
     timer<> metro { this,
         MIN_FUNCTION {
-            auto interval = lib::math::random(min, max);
+            auto interval = m_generator(distribution, min, max);
 
             interval_out.send(interval);
             bang_out.send("bang");
 
-            metro.delay(interval);
+            m_clicks.beat(interval);
+            if (drift_free)
+                metro.delay(m_schedule.advance(interval));
+            else
+                metro.delay(interval);
             return {};
         }
     };
@@ -72,18 +86,53 @@ public:
     };
 
 
+    using distributions = interval_generator::distributions;
+
+    enum_map distributions_range = {"uniform", "gaussian", "exponential", "euler"};
+
+    attribute<distributions> distribution { this, "distribution", distributions::uniform, distributions_range,
+        title {"Distribution"},
+        description {"Distribution of the generated intervals within the range. "
+                     "'uniform' makes every interval equally likely, 'gaussian' clusters the intervals around the center of the range, "
+                     "'exponential' produces the intervals of a Poisson process for natural sounding timing, "
+                     "and 'euler' is a low-discrepancy sequence that covers the range evenly."},
+        category {"Range"}, order {3}
+    };
+
+
+    attribute<int> seed { this, "seed", 0, title {"Random Seed"},
+        description {"Seed for the random number generator so that a sequence of intervals can be reproduced. "
+                     "A seed of 0 produces a different sequence for every instance."},
+        setter { MIN_FUNCTION {
+            int value = args[0];
+            m_generator.seed(static_cast<std::uint64_t>(value));
+            return {value};
+        }}
+    };
+
+
     attribute<bool> on { this, "on", false, title {"On/Off"},
         description {"Activate the timer."},
         setter { MIN_FUNCTION {
-            if (args[0] == true)
+            if (args[0] == true) {
+                m_schedule.start();
                 metro.delay(0.0);    // fire the first one straight-away
-            else
+            }
+            else {
                 metro.stop();
+                m_clicks.stop();
+            }
             return args;
         }}
     };
 
 
+    attribute<bool> drift_free { this, "drift_free", false, title {"Drift-Free Scheduling"},
+        description {"Schedule each bang relative to when the previous bang was due rather than when it actually happened. "
+                     "This prevents the lateness of the scheduler from accumulating so the timing does not drift over time."}
+    };
+
+
     message<> toggle { this, "int", "Toggle the state of the timer.",
         MIN_FUNCTION {
             on = args[0];
@@ -91,6 +140,19 @@ public:
         }
     };
 
+
+    message<> dspsetup { this, "dspsetup",
+        MIN_FUNCTION {
+            m_clicks.restart();
+            return {};
+        }
+    };
+
+
+    void operator()(audio_bundle input, audio_bundle output) {
+        m_clicks(output.samples(0), output.frame_count(), samplerate());
+    }
+
 };
 
 
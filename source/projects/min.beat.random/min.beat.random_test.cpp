@@ -61,3 +61,103 @@ SCENARIO("object produces correct output") {
         REQUIRE(output.size() > 0);
     }
 }
+
+
+SCENARIO("intervals are drawn from the requested distribution") {
+    using distributions = interval_generator::distributions;
+
+    constexpr auto low   = 250.0;
+    constexpr auto high  = 1500.0;
+    constexpr auto count = 100000;
+
+    // draw many intervals and return their mean and standard deviation, checking that they all lie within the range
+
+    auto measure = [&](interval_generator& generator, distributions distribution) {
+        double sum {};
+        double sum_of_squares {};
+
+        for (auto i = 0; i < count; ++i) {
+            auto x = generator(distribution, low, high);
+
+            REQUIRE(x >= low);
+            REQUIRE(x <= high);
+            sum += x;
+            sum_of_squares += x * x;
+        }
+
+        auto mean = sum / count;
+        return std::make_pair(mean, std::sqrt(sum_of_squares / count - mean * mean));
+    };
+
+    GIVEN("A seeded generator") {
+        interval_generator generator;
+        generator.seed(42);
+
+        WHEN("drawing from a uniform distribution") {
+            auto stats = measure(generator, distributions::uniform);
+
+            THEN("the mean is the center of the range and the deviation is that of a uniform distribution") {
+                REQUIRE(stats.first == Approx(875.0).epsilon(0.01));
+                REQUIRE(stats.second == Approx((high - low) / std::sqrt(12.0)).epsilon(0.01));
+            }
+        }
+        WHEN("drawing from a gaussian distribution") {
+            auto stats = measure(generator, distributions::gaussian);
+
+            THEN("the mean is the center of the range with three deviations to either side") {
+                REQUIRE(stats.first == Approx(875.0).epsilon(0.01));
+                REQUIRE(stats.second == Approx((high - low) / 6.0).epsilon(0.02));
+            }
+        }
+        WHEN("drawing from an exponential distribution") {
+            auto stats = measure(generator, distributions::exponential);
+
+            THEN("the mean is that of an exponential distribution truncated to the range") {
+                auto range = high - low;
+                auto scale = range / 2.0;
+
+                REQUIRE(stats.first == Approx(low + scale - range / (std::exp(range / scale) - 1.0)).epsilon(0.01));
+            }
+        }
+        WHEN("drawing from the euler sequence") {
+            THEN("the intervals cover the range evenly") {
+                std::vector<int> bins(10);
+
+                for (auto i = 0; i < 1000; ++i) {
+                    auto x = generator(distributions::euler, low, high);
+                    ++bins[static_cast<int>((x - low) / (high - low) * bins.size())];
+                }
+                for (auto bin : bins)
+                    REQUIRE(std::abs(bin - 100) <= 2);
+            }
+        }
+    }
+
+    GIVEN("Two generators") {
+        interval_generator a;
+        interval_generator b;
+
+        WHEN("they are given the same seed") {
+            a.seed(1234);
+            b.seed(1234);
+
+            THEN("they produce the same sequence") {
+                for (auto i = 0; i < 100; ++i)
+                    REQUIRE(a(distributions::uniform, low, high) == b(distributions::uniform, low, high));
+            }
+        }
+        WHEN("they are given different seeds") {
+            a.seed(1);
+            b.seed(2);
+
+            THEN("they produce different sequences") {
+                auto same = 0;
+                for (auto i = 0; i < 100; ++i) {
+                    if (a(distributions::uniform, low, high) == b(distributions::uniform, low, high))
+                        ++same;
+                }
+                REQUIRE(same == 0);
+            }
+        }
+    }
+}
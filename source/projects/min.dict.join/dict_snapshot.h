@@ -0,0 +1,326 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2018 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#pragma once
+
+#include "c74_min_api.h"
+#include "../shared/mapped_file.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+
+// A compact binary snapshot of a dictionary for fast preset recall.
+//
+// The file begins with a header and a table of the top-level keys sorted by name.
+// Each table record points at the key's name and its encoded value, so a single key can be found with a binary search
+// over the memory-mapped file and decoded without touching (or parsing) any other part of the snapshot.
+//
+//	header:		char[4] magic, uint32 version, uint32 key count, uint32 reserved
+//	table:		{ uint64 name offset, uint32 name length, uint32 reserved, uint64 value offset } per key
+//	values:		'a' uint32 count, then per atom: 'l' int64 | 'f' float64 | 's' uint32 length + bytes
+//				'd' uint32 count, then per entry: uint32 name length + bytes, value
+//
+// Numbers are stored in the byte order of the machine that wrote the file.
+// Atoms that are neither numbers nor symbols (e.g. dictionaries nested inside of arrays) are not stored.
+
+namespace dict_snapshot {
+
+	static constexpr char          magic[4] = {'M', 'D', 'J', 'B'};
+	static constexpr std::uint32_t version  = 1;
+	static constexpr size_t        header_size = 16;
+	static constexpr size_t        record_size = 24;
+
+
+	class writer {
+	public:
+		/// Serialize a dictionary into the binary snapshot format.
+		/// @param	d	The dictionary to serialize.
+		explicit writer(c74::max::t_dictionary* d) {
+			auto entries = sorted_keys(d);
+
+			m_data.resize(header_size + record_size * entries.size());
+			std::memcpy(&m_data[0], magic, sizeof(magic));
+			put_at<std::uint32_t>(4, version);
+			put_at<std::uint32_t>(8, static_cast<std::uint32_t>(entries.size()));
+
+			for (size_t i = 0; i < entries.size(); ++i) {
+				auto record = header_size + record_size * i;
+				auto name   = entries[i]->s_name;
+				auto length = std::strlen(name);
+
+				put_at<std::uint64_t>(record, m_data.size());
+				put_at<std::uint32_t>(record + 8, static_cast<std::uint32_t>(length));
+				m_data.insert(m_data.end(), name, name + length);
+				put_at<std::uint64_t>(record + 16, m_data.size());
+				put_value(d, entries[i]);
+			}
+		}
+
+		/// Write the snapshot to disk.
+		/// The file is first written next to the destination and then renamed so that readers never see a partial snapshot.
+		/// @param	filename	The absolute path of the file to write.
+		void write(const std::string& filename) const {
+			auto temp_filename = filename + ".tmp";
+			{
+				std::ofstream out {temp_filename, std::ios::binary | std::ios::trunc};
+				out.write(m_data.data(), m_data.size());
+				if (!out)
+					throw std::runtime_error("could not write " + temp_filename);
+			}
+			std::remove(filename.c_str());
+			if (std::rename(temp_filename.c_str(), filename.c_str()) != 0)
+				throw std::runtime_error("could not write " + filename);
+		}
+
+	private:
+		std::vector<char> m_data;
+
+		static std::vector<c74::max::t_symbol*> sorted_keys(c74::max::t_dictionary* d) {
+			long                 count {};
+			c74::max::t_symbol** keys {};
+
+			c74::max::dictionary_getkeys(d, &count, &keys);
+
+			std::vector<c74::max::t_symbol*> sorted(keys, keys + count);
+
+			if (keys)
+				c74::max::dictionary_freekeys(d, count, keys);
+			std::sort(sorted.begin(), sorted.end(), [](c74::max::t_symbol* a, c74::max::t_symbol* b) {
+				return std::strcmp(a->s_name, b->s_name) < 0;
+			});
+			return sorted;
+		}
+
+		template<typename T>
+		void put(T value) {
+			auto bytes = reinterpret_cast<const char*>(&value);
+			m_data.insert(m_data.end(), bytes, bytes + sizeof(T));
+		}
+
+		template<typename T>
+		void put_at(size_t offset, T value) {
+			std::memcpy(&m_data[offset], &value, sizeof(T));
+		}
+
+		void put_string(const char* s) {
+			auto length = std::strlen(s);
+			put<std::uint32_t>(static_cast<std::uint32_t>(length));
+			m_data.insert(m_data.end(), s, s + length);
+		}
+
+		void put_value(c74::max::t_dictionary* d, c74::max::t_symbol* key) {
+			if (c74::max::dictionary_entryisdictionary(d, key)) {
+				c74::max::t_object* sub {};
+
+				c74::max::dictionary_getdictionary(d, key, &sub);
+				put_dictionary(reinterpret_cast<c74::max::t_dictionary*>(sub));
+			}
+			else {
+				long              argc {};
+				c74::max::t_atom* argv {};
+
+				c74::max::dictionary_getatoms(d, key, &argc, &argv);
+				put_atoms(argc, argv);
+			}
+		}
+
+		void put_dictionary(c74::max::t_dictionary* d) {
+			auto entries = sorted_keys(d);
+
+			put<char>('d');
+			put<std::uint32_t>(static_cast<std::uint32_t>(entries.size()));
+			for (auto key : entries) {
+				put_string(key->s_name);
+				put_value(d, key);
+			}
+		}
+
+		void put_atoms(long argc, const c74::max::t_atom* argv) {
+			std::uint32_t count {};
+
+			for (auto i = 0; i < argc; ++i) {
+				auto type = argv[i].a_type;
+				if (type == c74::max::A_LONG || type == c74::max::A_FLOAT || type == c74::max::A_SYM)
+					++count;
+			}
+
+			put<char>('a');
+			put<std::uint32_t>(count);
+			for (auto i = 0; i < argc; ++i) {
+				const auto& a = argv[i];
+
+				switch (a.a_type) {
+					case c74::max::A_LONG:
+						put<char>('l');
+						put<std::int64_t>(a.a_w.w_long);
+						break;
+					case c74::max::A_FLOAT:
+						put<char>('f');
+						put<double>(a.a_w.w_float);
+						break;
+					case c74::max::A_SYM:
+						put<char>('s');
+						put_string(a.a_w.w_sym->s_name);
+						break;
+					default:
+						break;
+				}
+			}
+		}
+	};
+
+
+	/// Read access to a snapshot file.
+	/// Opening a snapshot only validates its header: entries are decoded when they are requested.
+
+	class reader {
+	public:
+		explicit reader(const std::string& filename)
+		: m_file {filename} {
+			if (m_file.size() < header_size || std::memcmp(m_file.data(), magic, sizeof(magic)) != 0)
+				throw std::runtime_error(filename + " is not a dictionary snapshot");
+			if (get_at<std::uint32_t>(4) != version)
+				throw std::runtime_error(filename + " was written by an unsupported version");
+			m_count = get_at<std::uint32_t>(8);
+			if (header_size + record_size * m_count > m_file.size())
+				throw std::runtime_error(filename + " is truncated");
+		}
+
+		/// The number of top-level keys in the snapshot.
+		size_t size() const {
+			return m_count;
+		}
+
+		/// Decode every top-level key into a dictionary.
+		/// @param	d	The dictionary to which the entries will be added.
+		void restore(c74::max::t_dictionary* d) const {
+			for (size_t i = 0; i < m_count; ++i)
+				restore_record(d, i);
+		}
+
+		/// Decode a single top-level key into a dictionary.
+		/// @param	d		The dictionary to which the entry will be added.
+		/// @param	key		The name of the key to restore.
+		/// @return			True if the key was found in the snapshot.
+		bool restore(c74::max::t_dictionary* d, const char* key) const {
+			auto   length = std::strlen(key);
+			size_t low    = 0;
+			size_t high   = m_count;
+
+			while (low < high) {
+				auto mid    = low + (high - low) / 2;
+				auto record = header_size + record_size * mid;
+				auto name   = m_file.data() + get_at<std::uint64_t>(record);
+				auto n      = get_at<std::uint32_t>(record + 8);
+				auto order  = std::memcmp(name, key, std::min<size_t>(n, length));
+
+				if (order == 0)
+					order = (n < length) ? -1 : (n > length ? 1 : 0);
+				if (order == 0) {
+					restore_record(d, mid);
+					return true;
+				}
+				if (order < 0)
+					low = mid + 1;
+				else
+					high = mid;
+			}
+			return false;
+		}
+
+	private:
+		mapped_file m_file;
+		size_t      m_count {};
+
+		template<typename T>
+		T get_at(size_t offset) const {
+			if (offset + sizeof(T) > m_file.size())
+				throw std::runtime_error("dictionary snapshot is truncated");
+
+			T value;
+			std::memcpy(&value, m_file.data() + offset, sizeof(T));
+			return value;
+		}
+
+		c74::max::t_symbol* get_symbol(size_t& offset) const {
+			auto length = get_at<std::uint32_t>(offset);
+
+			offset += sizeof(std::uint32_t);
+			if (offset + length > m_file.size())
+				throw std::runtime_error("dictionary snapshot is truncated");
+
+			std::string s {m_file.data() + offset, length};
+			offset += length;
+			return c74::max::gensym(s.c_str());
+		}
+
+		void restore_record(c74::max::t_dictionary* d, size_t index) const {
+			auto   record = header_size + record_size * index;
+			auto   name   = get_at<std::uint64_t>(record);
+			auto   length = get_at<std::uint32_t>(record + 8);
+			size_t offset = get_at<std::uint64_t>(record + 16);
+
+			if (name + length > m_file.size())
+				throw std::runtime_error("dictionary snapshot is truncated");
+
+			std::string key {m_file.data() + name, length};
+			restore_value(d, c74::max::gensym(key.c_str()), offset);
+		}
+
+		void restore_value(c74::max::t_dictionary* d, c74::max::t_symbol* key, size_t& offset) const {
+			auto type = get_at<char>(offset++);
+
+			if (type == 'd') {
+				auto count = get_at<std::uint32_t>(offset);
+				auto sub   = c74::max::dictionary_new();
+
+				// the nested dictionary is only owned by its parent once it has been appended
+
+				try {
+					offset += sizeof(std::uint32_t);
+					for (std::uint32_t i = 0; i < count; ++i) {
+						auto sub_key = get_symbol(offset);
+						restore_value(sub, sub_key, offset);
+					}
+				}
+				catch (...) {
+					c74::max::object_free(sub);
+					throw;
+				}
+				c74::max::dictionary_appenddictionary(d, key, reinterpret_cast<c74::max::t_object*>(sub));
+			}
+			else if (type == 'a') {
+				auto count = get_at<std::uint32_t>(offset);
+
+				offset += sizeof(std::uint32_t);
+
+				std::vector<c74::max::t_atom> as(count);
+
+				for (auto& a : as) {
+					auto atom_type = get_at<char>(offset++);
+
+					if (atom_type == 'l') {
+						c74::max::atom_setlong(&a, static_cast<c74::max::t_atom_long>(get_at<std::int64_t>(offset)));
+						offset += sizeof(std::int64_t);
+					}
+					else if (atom_type == 'f') {
+						c74::max::atom_setfloat(&a, get_at<double>(offset));
+						offset += sizeof(double);
+					}
+					else if (atom_type == 's')
+						c74::max::atom_setsym(&a, get_symbol(offset));
+					else
+						throw std::runtime_error("dictionary snapshot is corrupt");
+				}
+				c74::max::dictionary_appendatoms(d, key, static_cast<long>(as.size()), as.data());
+			}
+			else
+				throw std::runtime_error("dictionary snapshot is corrupt");
+		}
+	};
+
+}    // namespace dict_snapshot
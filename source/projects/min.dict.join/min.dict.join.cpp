@@ -4,6 +4,8 @@
 ///	@license	Use of this source code is governed by the MIT License found in the License.md file.
 
 #include "c74_min.h"
+#include "dict_snapshot.h"
+#include <unordered_map>
 
 using namespace c74::min;
 
@@ -15,9 +17,10 @@ public:
     MIN_AUTHOR		{ "Cycling '74" };
     MIN_RELATED		{ "min.beat.pattern, dict.join" };
 
-    inlet<>  left	{ this, "dictionary to combined with dictionary at right inlet", "" };
-    inlet<>  right	{ this, "dictionary to combined with dictionary at left inlet", "dictionary" };
-    outlet<> output	{ this, "dictionary of entries combined from both inlets", "dictionary" };
+    inlet<>  left		{ this, "dictionary to combined with dictionary at right inlet", "" };
+    inlet<>  right		{ this, "dictionary to combined with dictionary at left inlet", "dictionary" };
+    outlet<> output		{ this, "dictionary of entries combined from both inlets", "dictionary" };
+    outlet<> changes	{ this, "(list) keys modified by the most recent incremental merge" };
 
     argument<anything> name_arg { this, "dictionary-syntax", "Define an initial dictionary for joining." };
 
@@ -32,6 +35,32 @@ public:
     }
 
 
+    // How to resolve a key that is present in both dictionaries.
+
+    enum class policies : int { right, left, concatenate, sum, enum_count };
+
+    enum_map policies_range = {"right", "left", "concatenate", "sum"};
+
+    attribute<policies> policy { this, "policy", policies::right, policies_range,
+        description {"How to resolve a key present in both dictionaries. "
+                     "'right' keeps the entry from the right inlet, 'left' replaces it with the entry from the left inlet, "
+                     "'concatenate' appends the values from the left inlet to those from the right inlet, "
+                     "and 'sum' adds numeric values element by element (other values keep the entry from the right inlet)."}
+    };
+
+    attribute<bool> deep { this, "deep", false,
+        description {"Merge nested dictionaries recursively instead of treating them as single values. "
+                     "Nested dictionaries are merged in place inside the merged copy, without building intermediate dictionaries."}
+    };
+
+    attribute<bool> incremental { this, "incremental", false,
+        description {"Only apply the entries that changed since the previous dictionary arrived at the left inlet. "
+                     "The list of modified keys is sent from the right outlet and nothing is output if no key changed. "
+                     "Objects that refer to the dictionary by name (such as dict.view) are not told that it changed. "
+                     "Only used for shallow merges with the 'right' policy."}
+    };
+
+
     message<> bang { this, "bang", "Resend the most recently combined dictionary",
         MIN_FUNCTION {
             output.send("dictionary", dict_merged.name());
@@ -47,13 +76,26 @@ public:
                 dict d = {args[0]};
 
                 if (inlet == 0) {
-                    dict_merged = dict_right;     // start with our stored dict contents
-                    dict_merged.copyunique(d);    // now merge in any keys that are not duplicated in the incoming dict
-                    bang();                       // send the dictionary name out the outlet
-                    dict_merged.touch();          // notify anything listening remotely (e.g. dict.view objects) that we changed
+                    bool shallow_unique = (policy == policies::right && !deep);
+
+                    if (incremental && shallow_unique) {
+                        merge_incremental(d);
+                        m_stale = false;
+                    }
+                    else {
+                        dict_merged = dict_right;    // start with our stored dict contents
+                        if (shallow_unique)
+                            dict_merged.copyunique(d);    // now merge in any keys that are not duplicated in the incoming dict
+                        else
+                            merge_entries(dict_merged, d, policy, deep);
+                        bang();                 // send the dictionary name out the outlet
+                        dict_merged.touch();    // notify anything listening remotely (e.g. dict.view objects) that we changed
+                        m_stale = true;         // a full merge does not maintain the incremental cache
+                    }
                 }
                 else {
                     dict_right = d;
+                    m_stale    = true;
                 }
             }
             catch (std::exception& e) {
@@ -63,9 +105,300 @@ public:
         }
     };
 
+
+    message<> write_binary { this, "write_binary", "Write the most recently combined dictionary to a binary snapshot file. "
+        "Snapshots are much faster to recall than JSON files.",
+        MIN_FUNCTION {
+            try {
+                dict_snapshot::writer w {dict_merged};
+                w.write(snapshot_filename(args));
+            }
+            catch (std::exception& e) {
+                cerr << e.what() << endl;
+            }
+            return {};
+        }
+    };
+
+
+    message<> read_binary { this, "read_binary", "Recall a binary snapshot file written with 'write_binary' and send it as the combined dictionary. "
+        "Additional arguments name the keys to recall: only those entries are decoded from the file.",
+        MIN_FUNCTION {
+            try {
+                dict_snapshot::reader r {snapshot_filename(args)};
+
+                c74::max::dictionary_clear(dict_merged);
+                m_stale = true;
+
+                // don't leave the entries that were decoded before an error looking like a complete snapshot
+
+                try {
+                    if (args.size() > 1) {
+                        for (auto i = 1; i < args.size(); ++i) {
+                            symbol key = args[i];
+                            if (!r.restore(dict_merged, key.c_str()))
+                                cwarn << "no key named " << key << " in snapshot" << endl;
+                        }
+                    }
+                    else
+                        r.restore(dict_merged);
+                }
+                catch (...) {
+                    c74::max::dictionary_clear(dict_merged);
+                    throw;
+                }
+
+                bang();
+                dict_merged.touch();
+            }
+            catch (std::exception& e) {
+                cerr << e.what() << endl;
+            }
+            return {};
+        }
+    };
+
 private:
     dict dict_right		{ symbol(true) };
     dict dict_merged	{ symbol(true) };
+
+    // The values of the left-hand entries as they were last merged.
+    // Comparing against this cache lets us skip entries that have not changed.
+
+    struct cached_entry {
+        atoms         value;
+        std::uint64_t generation;
+    };
+
+    std::unordered_map<c74::max::t_symbol*, cached_entry>	m_cache;
+    std::uint64_t										m_generation	{ 0 };
+    bool												m_stale			{ true };    // dict_merged must be rebuilt before it can be patched
+
+
+    static string snapshot_filename(const atoms& args) {
+        if (args.empty())
+            throw std::runtime_error("no snapshot file specified");
+        try {
+            path p {static_cast<string>(args[0])};
+            return p;
+        }
+        catch (...) {
+            return static_cast<string>(args[0]);    // the file does not exist yet so we use the name as given
+        }
+    }
+
+
+    static bool same_atoms(long argc, const c74::max::t_atom* argv, const atoms& cached) {
+        if (static_cast<size_t>(argc) != cached.size())
+            return false;
+        for (auto i = 0; i < argc; ++i) {
+            const c74::max::t_atom& a = argv[i];
+            const c74::max::t_atom& b = cached[i];
+
+            if (a.a_type != b.a_type)
+                return false;
+            switch (a.a_type) {
+                case c74::max::A_LONG:
+                    if (a.a_w.w_long != b.a_w.w_long)
+                        return false;
+                    break;
+                case c74::max::A_FLOAT:
+                    if (a.a_w.w_float != b.a_w.w_float)
+                        return false;
+                    break;
+                case c74::max::A_SYM:
+                    if (a.a_w.w_sym != b.a_w.w_sym)
+                        return false;
+                    break;
+                default:
+                    return false;    // objects (e.g. dictionaries) may have been mutated in place, so we always treat them as changed
+            }
+        }
+        return true;
+    }
+
+
+    static void copy_entry(c74::max::t_dictionary* src, c74::max::t_dictionary* dst, c74::max::t_symbol* key) {
+        if (c74::max::dictionary_entryisdictionary(src, key)) {
+            c74::max::t_object* sub {};
+
+            c74::max::dictionary_getdictionary(src, key, &sub);
+            auto clone = c74::max::dictionary_clone(reinterpret_cast<c74::max::t_dictionary*>(sub));
+            c74::max::dictionary_appenddictionary(dst, key, reinterpret_cast<c74::max::t_object*>(clone));
+        }
+        else {
+            long               argc {};
+            c74::max::t_atom*  argv {};
+
+            c74::max::dictionary_getatoms(src, key, &argc, &argv);
+            c74::max::dictionary_appendatoms(dst, key, argc, argv);
+        }
+    }
+
+
+    static bool is_numeric(long argc, const c74::max::t_atom* argv) {
+        for (auto i = 0; i < argc; ++i) {
+            if (argv[i].a_type != c74::max::A_LONG && argv[i].a_type != c74::max::A_FLOAT)
+                return false;
+        }
+        return argc > 0;
+    }
+
+
+    // Resolve a key present in both dictionaries that cannot be merged recursively.
+
+    static void resolve_conflict(c74::max::t_dictionary* dst, c74::max::t_dictionary* src, c74::max::t_symbol* key, policies policy) {
+        if (policy == policies::right)
+            return;
+        if (policy == policies::left) {
+            copy_entry(src, dst, key);
+            return;
+        }
+
+        // concatenating and summing only make sense for atom arrays, dictionaries keep the entry from the right
+
+        if (c74::max::dictionary_entryisdictionary(src, key) || c74::max::dictionary_entryisdictionary(dst, key))
+            return;
+
+        long              dst_argc {};
+        c74::max::t_atom* dst_argv {};
+        long              src_argc {};
+        c74::max::t_atom* src_argv {};
+
+        c74::max::dictionary_getatoms(dst, key, &dst_argc, &dst_argv);
+        c74::max::dictionary_getatoms(src, key, &src_argc, &src_argv);
+
+        atoms result(dst_argv, dst_argv + dst_argc);
+
+        if (policy == policies::concatenate)
+            result.insert(result.end(), src_argv, src_argv + src_argc);
+        else {    // policies::sum
+            if (!is_numeric(dst_argc, dst_argv) || !is_numeric(src_argc, src_argv))
+                return;
+            for (auto i = 0; i < src_argc; ++i) {
+                const c74::max::t_atom& b = src_argv[i];
+
+                if (i >= dst_argc)
+                    result.push_back(b);
+                else if (result[i].a_type == c74::max::A_LONG && b.a_type == c74::max::A_LONG)
+                    c74::max::atom_setlong(&result[i], result[i].a_w.w_long + b.a_w.w_long);
+                else
+                    c74::max::atom_setfloat(&result[i], c74::max::atom_getfloat(&result[i]) + c74::max::atom_getfloat(&b));
+            }
+        }
+        c74::max::dictionary_appendatoms(dst, key, static_cast<long>(result.size()), result.data());
+    }
+
+
+    // Merge every entry of src into dst.
+    // Keys only present in src are copied, keys present in both are resolved according to the policy.
+    // When merging deeply, nested dictionaries present in both are merged in place rather than being replaced.
+
+    static void merge_entries(c74::max::t_dictionary* dst, c74::max::t_dictionary* src, policies policy, bool deep) {
+        long                 count {};
+        c74::max::t_symbol** keys {};
+
+        c74::max::dictionary_getkeys(src, &count, &keys);
+        for (auto i = 0; i < count; ++i) {
+            auto key = keys[i];
+
+            if (!c74::max::dictionary_hasentry(dst, key))
+                copy_entry(src, dst, key);
+            else if (deep && c74::max::dictionary_entryisdictionary(src, key) && c74::max::dictionary_entryisdictionary(dst, key)) {
+                c74::max::t_object* src_sub {};
+                c74::max::t_object* dst_sub {};
+
+                c74::max::dictionary_getdictionary(src, key, &src_sub);
+                c74::max::dictionary_getdictionary(dst, key, &dst_sub);
+                merge_entries(reinterpret_cast<c74::max::t_dictionary*>(dst_sub), reinterpret_cast<c74::max::t_dictionary*>(src_sub),
+                    policy, deep);
+            }
+            else
+                resolve_conflict(dst, src, key, policy);
+        }
+        if (keys)
+            c74::max::dictionary_freekeys(src, count, keys);
+    }
+
+
+    // Apply only the entries of the left dictionary that changed since the last merge.
+    // The semantics match the full merge: entries from the right dictionary always win.
+
+    void merge_incremental(dict& d) {
+        c74::max::t_dictionary* left  = d;
+        c74::max::t_dictionary* right = dict_right;
+        atoms                   modified;
+
+        if (m_stale) {
+            dict_merged = dict_right;
+            m_cache.clear();
+
+            long                 count {};
+            c74::max::t_symbol** keys {};
+
+            c74::max::dictionary_getkeys(right, &count, &keys);
+            for (auto i = 0; i < count; ++i)
+                modified.push_back(symbol(keys[i]));
+            if (keys)
+                c74::max::dictionary_freekeys(right, count, keys);
+        }
+
+        c74::max::t_dictionary* merged = dict_merged;
+
+        ++m_generation;
+
+        long                 count {};
+        c74::max::t_symbol** keys {};
+
+        c74::max::dictionary_getkeys(left, &count, &keys);
+        for (auto i = 0; i < count; ++i) {
+            auto key = keys[i];
+
+            if (c74::max::dictionary_hasentry(right, key))
+                continue;
+
+            long              argc {};
+            c74::max::t_atom* argv {};
+            auto              found   = m_cache.emplace(key, cached_entry {});
+            auto&             entry   = found.first->second;
+            bool              fresh   = found.second;
+            bool              is_dict = c74::max::dictionary_entryisdictionary(left, key);
+
+            entry.generation = m_generation;
+            if (!is_dict) {
+                c74::max::dictionary_getatoms(left, key, &argc, &argv);
+                if (!fresh && same_atoms(argc, argv, entry.value))
+                    continue;
+                entry.value.assign(argv, argv + argc);
+            }
+            else
+                entry.value.clear();
+
+            copy_entry(left, merged, key);
+            modified.push_back(symbol(key));
+        }
+        if (keys)
+            c74::max::dictionary_freekeys(left, count, keys);
+
+        // entries that were not refreshed in this generation have been removed from the left dictionary
+
+        for (auto iter = m_cache.begin(); iter != m_cache.end();) {
+            if (iter->second.generation != m_generation) {
+                c74::max::dictionary_deleteentry(merged, iter->first);
+                modified.push_back(symbol(iter->first));
+                iter = m_cache.erase(iter);
+            }
+            else
+                ++iter;
+        }
+
+        // the modified keys take the place of touch(), which would make every remote listener read the whole dictionary again
+
+        if (!modified.empty()) {
+            changes.send(modified);
+            bang();
+        }
+    }
 };
 
 MIN_EXTERNAL(dict_join);
@@ -5,6 +5,7 @@
 
 #include "c74_min_unittest.h"    // required unit test header
 #include "min.dict.join.cpp"     // need the source of our object so that we can access it
+#include <set>
 
 // Unit tests are written using the Catch framework as described at
 // https://github.com/philsquared/Catch/blob/master/docs/tutorial.md
@@ -20,5 +21,233 @@ SCENARIO("object produces correct output") {
         // check that the object instantiated successfully
 
         REQUIRE(my_object.inlets().size() == 2);
+        REQUIRE(my_object.outlets().size() == 2);
+
+        // incremental merging is opt-in
+
+        REQUIRE(my_object.incremental == false);
+
+        // by default entries from the right inlet win and nested dictionaries are not merged
+
+        REQUIRE(my_object.policy == dict_join::policies::right);
+        REQUIRE(my_object.deep == false);
+    }
+}
+
+
+// Dictionaries for the tests, made and read with the same calls the object uses.
+
+using entries = std::vector<std::pair<const char*, atoms>>;
+
+static c74::max::t_dictionary* fill(c74::max::t_dictionary* d, const entries& values) {
+    for (const auto& v : values) {
+        auto argv = const_cast<c74::max::t_atom*>(static_cast<const c74::max::t_atom*>(v.second.data()));
+        c74::max::dictionary_appendatoms(d, c74::max::gensym(v.first), static_cast<long>(v.second.size()), argv);
+    }
+    return d;
+}
+
+static void add_subdictionary(c74::max::t_dictionary* d, const char* key, const entries& values) {
+    auto sub = fill(c74::max::dictionary_new(), values);
+    c74::max::dictionary_appenddictionary(d, c74::max::gensym(key), reinterpret_cast<c74::max::t_object*>(sub));
+}
+
+static std::vector<double> numbers(c74::max::t_dictionary* d, const char* key) {
+    long              argc {};
+    c74::max::t_atom* argv {};
+
+    c74::max::dictionary_getatoms(d, c74::max::gensym(key), &argc, &argv);
+
+    std::vector<double> result;
+    for (auto i = 0; i < argc; ++i)
+        result.push_back(c74::max::atom_getfloat(argv + i));
+    return result;
+}
+
+static c74::max::t_dictionary* subdictionary(c74::max::t_dictionary* d, const char* key) {
+    c74::max::t_object* sub {};
+    c74::max::dictionary_getdictionary(d, c74::max::gensym(key), &sub);
+    return reinterpret_cast<c74::max::t_dictionary*>(sub);
+}
+static std::set<std::string> symbols(const atoms& as) {
+    std::set<std::string> result;
+    for (const auto& a : as)
+        result.insert(static_cast<symbol>(a).c_str());
+    return result;
+}
+
+
+
+SCENARIO("keys present in both dictionaries are resolved by the policy") {
+    ext_main(nullptr);
+
+    GIVEN("A right dictionary and a left dictionary with conflicting keys") {
+        test_wrapper<dict_join> an_instance;
+        dict_join&              my_object = an_instance;
+
+        dict right {symbol(true)};
+        dict left {symbol(true)};
+
+        fill(right, {{"a", {1, 2}}, {"b", {10}}, {"empty", {}}});
+        add_subdictionary(right, "sub", {{"x", {1}}});
+        fill(left, {{"a", {3}}, {"b", {5}}, {"c", {7}}, {"empty", {}}});
+        add_subdictionary(left, "sub", {{"x", {2}}, {"y", {3}}});
+
+        my_object.dictionary({right.name()}, 1);
+
+        // merge and return the dictionary that was output
+
+        auto merge = [&]() -> c74::max::t_dictionary* {
+            my_object.dictionary({left.name()}, 0);
+
+            auto& output = *c74::max::object_getoutput(my_object, 0);
+            REQUIRE(!output.empty());
+
+            symbol name = output.back()[1];
+            return c74::max::dictobj_findregistered_retain(name);
+        };
+
+        WHEN("the policy is 'right'") {
+            auto merged = merge();
+
+            THEN("the entries from the right inlet are kept and the others are added") {
+                REQUIRE((numbers(merged, "a") == std::vector<double> {1, 2}));
+                REQUIRE((numbers(merged, "b") == std::vector<double> {10}));
+                REQUIRE((numbers(merged, "c") == std::vector<double> {7}));
+                REQUIRE((numbers(subdictionary(merged, "sub"), "x") == std::vector<double> {1}));
+                REQUIRE(!c74::max::dictionary_hasentry(subdictionary(merged, "sub"), c74::max::gensym("y")));
+            }
+            c74::max::dictobj_release(merged);
+        }
+
+        WHEN("the policy is 'left'") {
+            my_object.policy = dict_join::policies::left;
+            auto merged = merge();
+
+            THEN("the entries from the left inlet replace those from the right") {
+                REQUIRE((numbers(merged, "a") == std::vector<double> {3}));
+                REQUIRE((numbers(merged, "b") == std::vector<double> {5}));
+                REQUIRE((numbers(merged, "c") == std::vector<double> {7}));
+                REQUIRE((numbers(subdictionary(merged, "sub"), "y") == std::vector<double> {3}));
+            }
+            c74::max::dictobj_release(merged);
+        }
+
+        WHEN("the policy is 'concatenate'") {
+            my_object.policy = dict_join::policies::concatenate;
+            auto merged = merge();
+
+            THEN("the values from the left inlet follow those from the right") {
+                REQUIRE((numbers(merged, "a") == std::vector<double> {1, 2, 3}));
+                REQUIRE((numbers(merged, "b") == std::vector<double> {10, 5}));
+                REQUIRE((numbers(merged, "c") == std::vector<double> {7}));
+                REQUIRE(numbers(merged, "empty").empty());
+                REQUIRE((numbers(subdictionary(merged, "sub"), "x") == std::vector<double> {1}));
+            }
+            c74::max::dictobj_release(merged);
+        }
+
+        WHEN("the policy is 'sum'") {
+            my_object.policy = dict_join::policies::sum;
+            auto merged = merge();
+
+            THEN("numeric values are added element by element") {
+                REQUIRE((numbers(merged, "a") == std::vector<double> {4, 2}));
+                REQUIRE((numbers(merged, "b") == std::vector<double> {15}));
+                REQUIRE((numbers(merged, "c") == std::vector<double> {7}));
+            }
+            c74::max::dictobj_release(merged);
+        }
+
+        WHEN("nested dictionaries are merged deeply") {
+            my_object.deep = true;
+            auto merged = merge();
+
+            THEN("the nested dictionaries are combined by the same policy") {
+                auto sub = subdictionary(merged, "sub");
+
+                REQUIRE((numbers(sub, "x") == std::vector<double> {1}));
+                REQUIRE((numbers(sub, "y") == std::vector<double> {3}));
+                REQUIRE((numbers(merged, "a") == std::vector<double> {1, 2}));
+            }
+            c74::max::dictobj_release(merged);
+        }
+    }
+}
+
+
+SCENARIO("an incremental merge only applies and reports the keys that changed") {
+    ext_main(nullptr);
+
+    GIVEN("An instance merging incrementally") {
+        test_wrapper<dict_join> an_instance;
+        dict_join&              my_object = an_instance;
+
+        my_object.incremental = true;
+
+        dict right {symbol(true)};
+        fill(right, {{"r", {1}}});
+        my_object.dictionary({right.name()}, 1);
+
+        auto& output  = *c74::max::object_getoutput(my_object, 0);
+        auto& changes = *c74::max::object_getoutput(my_object, 1);
+
+        // send a left dictionary and return the dictionary that was output
+
+        auto send_left = [&](const entries& values) -> c74::max::t_dictionary* {
+            dict left {symbol(true)};
+
+            fill(left, values);
+            my_object.dictionary({left.name()}, 0);
+            REQUIRE(!output.empty());
+
+            symbol name = output.back()[1];
+            return c74::max::dictobj_findregistered_retain(name);
+        };
+
+        WHEN("the first left dictionary arrives") {
+            auto merged = send_left({{"a", {1}}, {"b", {2}}, {"r", {5}}});
+
+            THEN("every key is reported and the entries from the right inlet win") {
+                REQUIRE(changes.size() == 1);
+                REQUIRE((symbols(changes[0]) == std::set<std::string> {"r", "a", "b"}));
+                REQUIRE((numbers(merged, "r") == std::vector<double> {1}));
+                REQUIRE((numbers(merged, "a") == std::vector<double> {1}));
+                REQUIRE((numbers(merged, "b") == std::vector<double> {2}));
+            }
+            c74::max::dictobj_release(merged);
+
+            AND_WHEN("a dictionary with a changed key and a new key arrives") {
+                merged = send_left({{"a", {1}}, {"b", {3}}, {"c", {4}}, {"r", {5}}});
+
+                THEN("only those keys are reported and applied") {
+                    REQUIRE(changes.size() == 2);
+                    REQUIRE((symbols(changes[1]) == std::set<std::string> {"b", "c"}));
+                    REQUIRE((numbers(merged, "b") == std::vector<double> {3}));
+                    REQUIRE((numbers(merged, "c") == std::vector<double> {4}));
+                    REQUIRE((numbers(merged, "r") == std::vector<double> {1}));
+                }
+                c74::max::dictobj_release(merged);
+
+                AND_WHEN("a key is removed and then the same dictionary arrives again") {
+                    merged = send_left({{"a", {1}}, {"b", {3}}, {"r", {5}}});
+
+                    REQUIRE(changes.size() == 3);
+                    REQUIRE((symbols(changes[2]) == std::set<std::string> {"c"}));
+                    REQUIRE(!c74::max::dictionary_hasentry(merged, c74::max::gensym("c")));
+                    c74::max::dictobj_release(merged);
+
+                    auto outputs = output.size();
+
+                    merged = send_left({{"a", {1}}, {"b", {3}}, {"r", {5}}});
+
+                    THEN("the removal is reported and the repeat changes nothing and outputs nothing") {
+                        REQUIRE(changes.size() == 3);
+                        REQUIRE(output.size() == outputs);
+                    }
+                    c74::max::dictobj_release(merged);
+                }
+            }
+        }
     }
 }
@@ -0,0 +1,230 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2018 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#include "c74_min.h"
+#include "../shared/latency_histogram.h"
+#include <algorithm>
+#include <limits>
+
+using namespace c74::min;
+
+
+// The timing of one signal vector as measured on the audio thread.
+
+struct vector_timing {
+    double interval;    ///< ms since the previous vector
+    double headroom;    ///< ms remaining before the deadline for this vector, negative if it was missed
+};
+
+
+// Summary statistics for one quantity, gathered on the main thread.
+
+class timing_statistics {
+public:
+    void add(double value) {
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+        m_sum += value;
+        ++m_count;
+        m_histogram.record(static_cast<std::uint64_t>(std::max(value, 0.0) * 1000.0));
+    }
+
+    void clear() {
+        m_min   = std::numeric_limits<double>::max();
+        m_max   = std::numeric_limits<double>::lowest();
+        m_sum   = 0.0;
+        m_count = 0;
+        m_histogram.clear();
+    }
+
+    bool   empty() const { return m_count == 0; }
+    double min() const { return m_min; }
+    double max() const { return m_max; }
+    double mean() const { return m_sum / m_count; }
+
+    /// The value at a percentile in ms. Negative values are counted as zero.
+    double percentile(double percentile) const {
+        return m_histogram.percentile(percentile) / 1000.0;
+    }
+
+private:
+    latency_histogram m_histogram;
+    double            m_min { std::numeric_limits<double>::max() };
+    double            m_max { std::numeric_limits<double>::lowest() };
+    double            m_sum { 0.0 };
+    size_t            m_count { 0 };
+};
+
+
+class dspmonitor : public object<dspmonitor>, public vector_operator<> {
+public:
+    MIN_DESCRIPTION	{ "Monitor the timing of the audio thread. "
+                      "[min.dspmonitor~] measures when each signal vector is processed, "
+                      "how much time is left before the audio would fall behind the output device, "
+                      "and counts the vectors that missed that deadline." };
+    MIN_TAGS		{ "benchmarking" };
+    MIN_AUTHOR		{ "Cycling '74" };
+    MIN_RELATED		{ "min.stress~, adstatus, min.threadcheck" };
+
+    inlet<>  input	{ this, "(signal) any signal, the monitor runs while audio is on" };
+    outlet<> output	{ this, "(list) timing statistics in ms: "
+                            "'interval' min mean max p50 p99 p99.9, "
+                            "'headroom' min mean max p50 p1 p0.1, "
+                            "'misses' missed-vectors total-vectors dropped-measurements" };
+
+    dspmonitor(const atoms& args = {}) {
+        m_timer.delay(k_poll_interval);
+    }
+
+    attribute<number, threadsafe::yes, limit::clamp> deadline { this, "deadline", 0.0,
+        range {0.0, 1000.0},
+        description {"How far in ms the audio may fall behind the sample clock before the output device runs dry. "
+                     "Set this to the duration of the I/O vector. "
+                     "Zero uses the duration of the signal vector, which is right when the I/O and signal vector sizes are the same."}
+    };
+
+    attribute<number, threadsafe::no, limit::clamp> interval { this, "interval", 1000.0,
+        range {100.0, 60000.0},
+        description {"Time in ms between reports of the statistics."}
+    };
+
+    message<> dspsetup { this, "dspsetup",
+        MIN_FUNCTION {
+            m_restart = true;
+            return {};
+        }
+    };
+
+    message<> clear { this, "clear", "Forget the measurements made since the last report.",
+        MIN_FUNCTION {
+            drain();
+            reset();
+            return {};
+        }
+    };
+
+    // The audio thread only takes two readings of the clock and pushes them onto a lock-free ring.
+    // All of the statistics are calculated on the main thread.
+
+    void operator()(audio_bundle input, audio_bundle output) {
+        auto now       = c74::max::systimer_gettime();
+        auto vector_ms = input.frame_count() / samplerate() * 1000.0;
+
+        if (m_restart) {
+            m_restart  = false;
+            m_anchor   = now;
+            m_elapsed  = 0.0;
+            m_previous = now;
+            m_vector   = vector_ms;
+            return;
+        }
+
+        // How late is this vector compared with the sample clock?
+        // The anchor follows the earliest vectors so that the lateness is never negative,
+        // and it creeps slowly forward so that the drift between the device clock and the system clock is absorbed.
+
+        m_elapsed += m_vector;
+
+        auto lateness = now - (m_anchor + m_elapsed);
+
+        if (lateness < 0.0) {
+            m_anchor += lateness;
+            lateness = 0.0;
+        }
+        else {
+            auto creep = std::min(lateness, vector_ms * k_drift);
+
+            m_anchor += creep;
+            lateness -= creep;
+        }
+
+        auto limit    = deadline > 0.0 ? deadline.get() : vector_ms;
+        auto headroom = limit - lateness;
+
+        // after a dropout the audio stays behind by the length of the dropout, so start measuring again from here
+
+        if (headroom < 0.0)
+            m_anchor += lateness;
+
+        if (!m_timings.try_enqueue({now - m_previous, headroom}))
+            ++m_dropped;
+
+        m_previous = now;
+        m_vector   = vector_ms;
+    }
+
+private:
+    fifo<vector_timing>        m_timings { 4096 };
+    std::atomic<bool>          m_restart { true };
+    std::atomic<std::uint64_t> m_dropped { 0 };    ///< measurements lost because the ring was full
+
+    // owned by the audio thread
+
+    double m_anchor { 0.0 };      ///< system time corresponding to the first sample
+    double m_elapsed { 0.0 };     ///< ms of audio before the current vector
+    double m_previous { 0.0 };    ///< system time of the previous vector
+    double m_vector { 0.0 };      ///< duration of the previous vector
+
+    // owned by the main thread
+
+    timing_statistics m_intervals;
+    timing_statistics m_headroom;
+    std::uint64_t     m_misses { 0 };
+    std::uint64_t     m_vectors { 0 };
+    double            m_since_report { 0.0 };
+
+    static constexpr double k_poll_interval	{ 50.0 };      ///< ms between emptying the ring
+    static constexpr double k_drift			{ 0.0001 };    ///< largest clock drift absorbed, as a fraction of the time elapsed
+
+
+    timer<timer_options::defer_delivery> m_timer { this,
+        MIN_FUNCTION {
+            drain();
+            m_since_report += k_poll_interval;
+            if (m_since_report >= interval) {
+                report();
+                reset();
+            }
+            m_timer.delay(k_poll_interval);
+            return {};
+        }
+    };
+
+
+    void drain() {
+        vector_timing timing;
+
+        while (m_timings.try_dequeue(timing)) {
+            m_intervals.add(timing.interval);
+            m_headroom.add(timing.headroom);
+            if (timing.headroom < 0.0)
+                ++m_misses;
+            ++m_vectors;
+        }
+    }
+
+
+    void report() {
+        if (!m_intervals.empty()) {
+            output.send("interval", m_intervals.min(), m_intervals.mean(), m_intervals.max(),
+                m_intervals.percentile(50.0), m_intervals.percentile(99.0), m_intervals.percentile(99.9));
+            output.send("headroom", m_headroom.min(), m_headroom.mean(), m_headroom.max(),
+                m_headroom.percentile(50.0), m_headroom.percentile(1.0), m_headroom.percentile(0.1));
+        }
+        output.send("misses", static_cast<long>(m_misses), static_cast<long>(m_vectors), static_cast<long>(m_dropped.exchange(0)));
+    }
+
+
+    void reset() {
+        m_intervals.clear();
+        m_headroom.clear();
+        m_misses       = 0;
+        m_vectors      = 0;
+        m_since_report = 0.0;
+    }
+};
+
+
+MIN_EXTERNAL(dspmonitor);
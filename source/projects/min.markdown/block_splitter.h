@@ -0,0 +1,785 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2018 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+extern "C" const char* hoedown_find_block_tag(const char* str, unsigned int len);
+
+
+/// Splitting a Markdown document into runs of top-level blocks that hoedown renders the same way on their own
+/// as it does within the whole document.
+///
+/// The split follows hoedown's own block parser: each function below is the part of the matching function in
+/// hoedown/src/document.c that finds where a block ends, for the extensions that min.markdown enables (fenced code only).
+/// A document is only split where blocks are separated by an empty line and where the block before the split does not
+/// depend on what follows it, so rendering the runs one by one and joining the HTML gives the same HTML as rendering the
+/// whole document.
+/// Link references are collected separately since a run may use a reference that is defined in another run.
+
+namespace block_splitter {
+
+	/// A run of blocks, as a range of bytes of the document.
+	struct run {
+		size_t offset;
+		size_t size;
+	};
+
+
+	/// A link reference definition.
+	struct reference {
+		std::string id;		///< lower-cased
+		run         definition;
+	};
+
+
+	/// A document split into runs.
+	struct outline {
+		bool                   usable { false };	///< false if the document cannot be split and must be rendered whole
+		std::vector<run>       runs;
+		std::vector<reference> references;
+		std::string            definitions;		///< every link reference definition in the document, each followed by an empty line
+	};
+
+
+	namespace detail {
+
+		// hoedown's tests for the start of each kind of block
+
+		inline size_t is_empty(const uint8_t* data, size_t size) {
+			size_t i;
+
+			for (i = 0; i < size && data[i] != '\n'; i++)
+				if (data[i] != ' ')
+					return 0;
+			return i + 1;
+		}
+
+
+		inline bool is_space(int c) {
+			return c == ' ' || c == '\n';
+		}
+
+
+		inline bool is_hrule(const uint8_t* data, size_t size) {
+			size_t i = 0, n = 0;
+
+			if (size < 3)
+				return false;
+			if (data[0] == ' ') { i++;
+			if (data[1] == ' ') { i++;
+			if (data[2] == ' ') { i++; } } }
+
+			if (i + 2 >= size || (data[i] != '*' && data[i] != '-' && data[i] != '_'))
+				return false;
+
+			auto c = data[i];
+			while (i < size && data[i] != '\n') {
+				if (data[i] == c)
+					n++;
+				else if (data[i] != ' ')
+					return false;
+				i++;
+			}
+			return n >= 3;
+		}
+
+
+		inline int is_headerline(const uint8_t* data, size_t size) {
+			size_t i = 0;
+
+			if (data[i] == '=') {
+				for (i = 1; i < size && data[i] == '='; i++);
+				while (i < size && data[i] == ' ') i++;
+				return (i >= size || data[i] == '\n') ? 1 : 0;
+			}
+			if (data[i] == '-') {
+				for (i = 1; i < size && data[i] == '-'; i++);
+				while (i < size && data[i] == ' ') i++;
+				return (i >= size || data[i] == '\n') ? 2 : 0;
+			}
+			return 0;
+		}
+
+
+		inline int is_next_headerline(const uint8_t* data, size_t size) {
+			size_t i = 0;
+
+			while (i < size && data[i] != '\n')
+				i++;
+			if (++i >= size)
+				return 0;
+			return is_headerline(data + i, size - i);
+		}
+
+
+		inline size_t prefix_quote(const uint8_t* data, size_t size) {
+			size_t i = 0;
+
+			if (i < size && data[i] == ' ') i++;
+			if (i < size && data[i] == ' ') i++;
+			if (i < size && data[i] == ' ') i++;
+
+			if (i < size && data[i] == '>')
+				return (i + 1 < size && data[i + 1] == ' ') ? i + 2 : i + 1;
+			return 0;
+		}
+
+
+		inline size_t prefix_code(const uint8_t* data, size_t size) {
+			return (size > 3 && data[0] == ' ' && data[1] == ' ' && data[2] == ' ' && data[3] == ' ') ? 4 : 0;
+		}
+
+
+		inline size_t prefix_oli(const uint8_t* data, size_t size) {
+			size_t i = 0;
+
+			if (i < size && data[i] == ' ') i++;
+			if (i < size && data[i] == ' ') i++;
+			if (i < size && data[i] == ' ') i++;
+
+			if (i >= size || data[i] < '0' || data[i] > '9')
+				return 0;
+			while (i < size && data[i] >= '0' && data[i] <= '9')
+				i++;
+			if (i + 1 >= size || data[i] != '.' || data[i + 1] != ' ')
+				return 0;
+			if (is_next_headerline(data + i, size - i))
+				return 0;
+			return i + 2;
+		}
+
+
+		inline size_t prefix_uli(const uint8_t* data, size_t size) {
+			size_t i = 0;
+
+			if (i < size && data[i] == ' ') i++;
+			if (i < size && data[i] == ' ') i++;
+			if (i < size && data[i] == ' ') i++;
+
+			if (i + 1 >= size || (data[i] != '*' && data[i] != '+' && data[i] != '-') || data[i + 1] != ' ')
+				return 0;
+			if (is_next_headerline(data + i, size - i))
+				return 0;
+			return i + 2;
+		}
+
+
+		inline size_t is_codefence(const uint8_t* data, size_t size, size_t* width, uint8_t* chr) {
+			size_t i = 0, n = 1;
+
+			if (size < 3)
+				return 0;
+			if (data[0] == ' ') { i++;
+			if (data[1] == ' ') { i++;
+			if (data[2] == ' ') { i++; } } }
+
+			auto c = data[i];
+			if (i + 2 >= size || !(c == '~' || c == '`'))
+				return 0;
+			while (++i < size && data[i] == c)
+				++n;
+			if (n < 3)
+				return 0;
+
+			*width = n;
+			*chr   = c;
+			return i;
+		}
+
+
+		inline size_t parse_codefence(const uint8_t* data, size_t size, size_t* width, uint8_t* chr) {
+			size_t i, w, lang_start;
+
+			i = w = is_codefence(data, size, width, chr);
+			if (i == 0)
+				return 0;
+
+			while (i < size && is_space(data[i]))
+				i++;
+			lang_start = i;
+
+			// a fence with another run of the fence character after it is a code span
+
+			i = lang_start + 2;
+			while (i < size && !(data[i] == *chr && data[i - 1] == *chr && data[i - 2] == *chr))
+				i++;
+			return i < size ? 0 : w;
+		}
+
+
+		// where each kind of block ends, as an offset from its start, or 0 if it is not that kind of block
+
+		inline size_t atxheader_end(const uint8_t* data, size_t size) {
+			size_t end = 0;
+
+			while (end < size && data[end] != '\n')
+				end++;
+			return end;
+		}
+
+
+		inline bool same_tag(const uint8_t* data, const char* tag, size_t tag_len) {
+			for (size_t i = 0; i < tag_len; ++i)
+				if (std::tolower(data[i]) != std::tolower(static_cast<unsigned char>(tag[i])))
+					return false;
+			return true;
+		}
+
+
+		inline size_t htmlblock_is_end(const char* tag, size_t tag_len, const uint8_t* data, size_t size) {
+			size_t i = tag_len + 3, w;
+
+			if (i > size || data[1] != '/' || !same_tag(data + 2, tag, tag_len) || data[tag_len + 2] != '>')
+				return 0;
+			if ((w = is_empty(data + i, size - i)) == 0 && i < size)
+				return 0;
+			return i + w;
+		}
+
+
+		inline size_t htmlblock_find_end(const char* tag, size_t tag_len, const uint8_t* data, size_t size) {
+			size_t i = 0;
+
+			while (true) {
+				while (i < size && data[i] != '<')
+					i++;
+				if (i >= size)
+					return 0;
+
+				auto w = htmlblock_is_end(tag, tag_len, data + i, size - i);
+				if (w)
+					return i + w;
+				i++;
+			}
+		}
+
+
+		inline size_t htmlblock_find_end_strict(const char* tag, size_t tag_len, const uint8_t* data, size_t size) {
+			size_t i = 0, mark;
+
+			while (true) {
+				mark = i;
+				while (i < size && data[i] != '\n')
+					i++;
+				if (i < size)
+					i++;
+				if (i == mark)
+					return 0;
+
+				if (data[mark] == ' ' && mark > 0)
+					continue;
+				mark += htmlblock_find_end(tag, tag_len, data + mark, i - mark);
+				if (mark == i && (is_empty(data + i, size - i) || i >= size))
+					return i;
+			}
+		}
+
+
+		inline size_t htmlblock_end(const uint8_t* data, size_t size) {
+			size_t      i, j = 0;
+			const char* tag = nullptr;
+
+			if (size < 2 || data[0] != '<')
+				return 0;
+
+			i = 1;
+			while (i < size && data[i] != '>' && data[i] != ' ')
+				i++;
+			if (i < size)
+				tag = hoedown_find_block_tag(reinterpret_cast<const char*>(data) + 1, static_cast<unsigned int>(i - 1));
+
+			if (!tag) {
+				if (size > 5 && data[1] == '!' && data[2] == '-' && data[3] == '-') {
+					i = 5;
+					while (i < size && !(data[i - 2] == '-' && data[i - 1] == '-' && data[i] == '>'))
+						i++;
+					i++;
+					if (i < size)
+						j = is_empty(data + i, size - i);
+					if (j)
+						return i + j;
+				}
+
+				if (size > 4 && (data[1] == 'h' || data[1] == 'H') && (data[2] == 'r' || data[2] == 'R')) {
+					i = 3;
+					while (i < size && data[i] != '>')
+						i++;
+					if (i + 1 < size) {
+						i++;
+						j = is_empty(data + i, size - i);
+						if (j)
+							return i + j;
+					}
+				}
+				return 0;
+			}
+
+			auto tag_len = std::strlen(tag);
+			auto end     = htmlblock_find_end_strict(tag, tag_len, data, size);
+
+			if (!end && std::strcmp(tag, "ins") != 0 && std::strcmp(tag, "del") != 0)
+				end = htmlblock_find_end(tag, tag_len, data, size);
+			return end;
+		}
+
+
+		inline size_t fencedcode_end(const uint8_t* data, size_t size) {
+			size_t  i = 0, line_start, w, w2, width, width2;
+			uint8_t chr, chr2;
+
+			while (i < size && data[i] != '\n')
+				i++;
+			w = parse_codefence(data, i, &width, &chr);
+			if (!w)
+				return 0;
+
+			i++;
+			while ((line_start = i) < size) {
+				while (i < size && data[i] != '\n')
+					i++;
+
+				w2 = is_codefence(data + line_start, i - line_start, &width2, &chr2);
+				if (w == w2 && width == width2 && chr == chr2 && is_empty(data + (line_start + w), i - (line_start + w)))
+					break;
+				i++;
+			}
+			return i < size ? i : size;
+		}
+
+
+		inline size_t blockquote_end(const uint8_t* data, size_t size) {
+			size_t beg = 0, end = 0;
+
+			while (beg < size) {
+				for (end = beg + 1; end < size && data[end - 1] != '\n'; end++);
+
+				if (!prefix_quote(data + beg, end - beg)
+					&& is_empty(data + beg, end - beg)
+					&& (end >= size || (prefix_quote(data + end, size - end) == 0 && !is_empty(data + end, size - end))))
+					break;
+				beg = end;
+			}
+			return end;
+		}
+
+
+		inline size_t blockcode_end(const uint8_t* data, size_t size) {
+			size_t beg = 0, end;
+
+			while (beg < size) {
+				for (end = beg + 1; end < size && data[end - 1] != '\n'; end++);
+
+				if (!prefix_code(data + beg, end - beg) && !is_empty(data + beg, end - beg))
+					break;
+				beg = end;
+			}
+			return beg;
+		}
+
+
+		/// How a list ended, which decides whether the blocks after it can be rendered apart from it.
+		struct list_end {
+			size_t size;
+			bool   at_item;		///< ended at what looked like another item after an empty line, which makes the last item a block
+		};
+
+
+		inline size_t listitem_end(const uint8_t* data, size_t size, bool ordered, bool& ended, bool& at_item) {
+			size_t beg, end, orgpre = 0, i, pre;
+			bool   in_empty = false, in_fence = false;
+
+			while (orgpre < 3 && orgpre < size && data[orgpre] == ' ')
+				orgpre++;
+
+			beg = prefix_uli(data, size);
+			if (!beg)
+				beg = prefix_oli(data, size);
+			if (!beg)
+				return 0;
+
+			at_item = false;
+			end     = beg;
+			while (end < size && data[end - 1] != '\n')
+				end++;
+			beg = end;
+
+			while (beg < size) {
+				size_t  has_next_uli = 0, has_next_oli = 0, width;
+				uint8_t chr;
+
+				end++;
+				while (end < size && data[end - 1] != '\n')
+					end++;
+
+				if (is_empty(data + beg, end - beg)) {
+					in_empty = true;
+					beg      = end;
+					continue;
+				}
+
+				i = 0;
+				while (i < 4 && beg + i < end && data[beg + i] == ' ')
+					i++;
+				pre = i;
+
+				if (is_codefence(data + beg + i, end - beg - i, &width, &chr))
+					in_fence = !in_fence;
+
+				if (!in_fence) {
+					has_next_uli = prefix_uli(data + beg + i, end - beg - i);
+					has_next_oli = prefix_oli(data + beg + i, end - beg - i);
+				}
+
+				if ((has_next_uli && !is_hrule(data + beg + i, end - beg - i)) || has_next_oli) {
+					if (pre <= orgpre) {
+						if (in_empty && ((ordered && has_next_uli) || (!ordered && has_next_oli)))
+							ended = true;
+						at_item = in_empty;
+						break;
+					}
+				}
+				else if (in_empty && pre == 0) {
+					ended = true;
+					break;
+				}
+
+				in_empty = false;
+				beg      = end;
+			}
+			return beg;
+		}
+
+
+		inline list_end list_end_of(const uint8_t* data, size_t size, bool ordered) {
+			size_t i       = 0;
+			bool   ended   = false;
+			bool   at_item = false;
+
+			while (i < size) {
+				auto j = listitem_end(data + i, size - i, ordered, ended, at_item);
+				i += j;
+				if (!j || ended)
+					break;
+			}
+			return {i, at_item};
+		}
+
+
+		inline size_t paragraph_end(const uint8_t* data, size_t size) {
+			size_t i = 0, end = 0;
+
+			while (i < size) {
+				for (end = i + 1; end < size && data[end - 1] != '\n'; end++);
+
+				if (is_empty(data + i, size - i))
+					break;
+				if (is_headerline(data + i, size - i))
+					break;
+				if (data[i] == '#' || is_hrule(data + i, size - i) || prefix_quote(data + i, size - i)) {
+					end = i;
+					break;
+				}
+				i = end;
+			}
+			return end;
+		}
+
+
+		// hoedown's first pass: link references become empty lines and tabs are expanded
+
+		inline void expand_tabs(std::string& out, const char* line, size_t size) {
+			size_t i = 0, column = 0;
+
+			if (!std::memchr(line, '\t', size)) {
+				out.append(line, size);
+				return;
+			}
+
+			while (i < size) {
+				auto start = i;
+
+				while (i < size && line[i] != '\t') {
+					if ((line[i] & 0xc0) != 0x80)
+						column++;
+					i++;
+				}
+				out.append(line + start, i - start);
+				if (i >= size)
+					break;
+				do {
+					out += ' ';
+					column++;
+				} while (column % 4);
+				i++;
+			}
+		}
+
+
+		// Whether a line starts a link reference definition, returning its id and the offset of the colon after it.
+		// This only looks at the start of the line so it finds a few lines that are not references,
+		// which the caller catches by checking that the references render to nothing.
+
+		inline bool is_reference(const char* line, size_t size, std::string& id, size_t& colon) {
+			size_t i = 0;
+
+			while (i < 3 && i < size && line[i] == ' ')
+				i++;
+			if (i >= size || line[i] != '[')
+				return false;
+
+			auto start = ++i;
+			while (i < size && line[i] != ']')
+				i++;
+			if (i + 1 >= size || line[i + 1] != ':')
+				return false;
+
+			id.clear();
+			for (auto c = start; c < i; ++c)
+				id += static_cast<char>(std::tolower(static_cast<unsigned char>(line[c])));
+			colon = i + 1;
+			return true;
+		}
+
+
+		inline bool is_blank(const char* line, size_t size) {
+			for (size_t i = 0; i < size; ++i)
+				if (line[i] != ' ' && line[i] != '\t')
+					return false;
+			return true;
+		}
+
+	}    // namespace detail
+
+
+	/// Split a document into runs of blocks.
+	/// @param	data			The document.
+	/// @param	size			The size of the document.
+	/// @param	accept			Called with outline::definitions once they are known, returning false if the document should not be split.
+	template<class accept_references>
+	outline split(const char* data, size_t size, accept_references accept) {
+		using namespace detail;
+
+		outline result;
+		size_t  offset = 0;
+
+		if (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+			offset = 3;
+
+		// hoedown treats a lone carriage return as a line break; rather than follow that, leave such documents whole
+
+		for (auto cr = static_cast<const char*>(std::memchr(data + offset, '\r', size - offset)); cr; cr = static_cast<const char*>(std::memchr(cr + 1, '\r', data + size - cr - 1))) {
+			if (cr + 1 == data + size || cr[1] != '\n')
+				return result;
+		}
+
+		// the first pass: the text that hoedown parses into blocks, with where each of its lines came from
+
+		struct line {
+			size_t text;		///< offset in the text
+			size_t begin;		///< range of the document
+			size_t end;
+		};
+
+		std::string           text;
+		std::vector<line>     lines;
+		std::set<std::string> ids;
+		std::string           id;
+		size_t                colon;
+
+		text.reserve(size - offset);
+
+		auto line_end = [&](size_t begin) {
+			auto end = static_cast<const char*>(std::memchr(data + begin, '\n', size - begin));
+			return end ? static_cast<size_t>(end - data) : size;
+		};
+		auto content_size = [&](size_t begin, size_t end) {
+			return (end > begin && data[end - 1] == '\r') ? end - begin - 1 : end - begin;
+		};
+
+		for (auto begin = offset; begin < size;) {
+			auto end  = line_end(begin);
+			auto next = end < size ? end + 1 : size;
+
+			if (is_reference(data + begin, content_size(begin, end), id, colon)) {
+				// a reference is replaced by an empty line, and may run on to a second line for its link and a third for its title
+
+				if (!ids.insert(id).second)
+					return result;
+
+				auto after = data + begin + colon + 1;
+				auto stop  = data + begin + content_size(begin, end);
+				auto extra = 0;
+
+				while (after < stop && *after == ' ')
+					++after;
+				if (after == stop)
+					extra = 2;
+				else {
+					while (after < stop && *after != ' ')
+						++after;
+					if (is_blank(after, stop - after))
+						extra = 1;
+				}
+
+				for (; extra > 0 && next < size; --extra) {
+					auto following      = line_end(next);
+					auto following_size = content_size(next, following);
+					auto first          = data + next;
+
+					if (extra == 2) {
+						if (is_blank(first, following_size))
+							break;
+					}
+					else {
+						auto stop_at = first + following_size;
+
+						while (first < stop_at && *first == ' ')
+							++first;
+						if (first == stop_at || (*first != '"' && *first != '\'' && *first != '('))
+							break;
+					}
+					end  = following;
+					next = end < size ? end + 1 : size;
+				}
+
+				// each reference is followed by an empty line so that it cannot run on to the next one
+
+				result.references.push_back({id, {begin, next - begin}});
+				result.definitions.append(data + begin, next - begin);
+				if (result.definitions.back() != '\n')
+					result.definitions += '\n';
+				result.definitions += '\n';
+				lines.push_back({text.size(), begin, next});
+				text += '\n';
+			}
+			else {
+				lines.push_back({text.size(), begin, next});
+				expand_tabs(text, data + begin, content_size(begin, end));
+				text += '\n';
+			}
+			begin = next;
+		}
+
+		if (!accept(result.definitions))
+			return result;
+
+		// the second pass: find the top-level blocks as hoedown's parse_block() does and start a run at each block that
+		// follows an empty line, unless the block before it is a list that ended at an item of the other kind of list
+
+		auto   bytes   = reinterpret_cast<const uint8_t*>(text.data());
+		auto   length  = text.size();
+		size_t beg     = 0;
+		size_t current = 0;		///< index into lines
+		bool   joined  = false;	///< the block before the next one must be in the same run
+		size_t first   = 0;		///< the first line of the current run
+		size_t last    = 0;		///< one past the last line of the current run
+		bool   started = false;
+
+		auto line_at = [&](size_t position) {
+			while (current + 1 < lines.size() && lines[current + 1].text <= position)
+				++current;
+			return current;
+		};
+		auto finish = [&] {
+			if (started)
+				result.runs.push_back({lines[first].begin, lines[last - 1].end - lines[first].begin});
+		};
+
+		while (beg < length) {
+			auto   block = bytes + beg;
+			auto   rest  = length - beg;
+			size_t size_of;
+			bool   ends_at_item = false;
+
+			if (block[0] == '#')
+				size_of = atxheader_end(block, rest);
+			else if (block[0] == '<' && (size_of = htmlblock_end(block, rest)) != 0)
+				;
+			else if ((size_of = is_empty(block, rest)) != 0) {
+				beg += size_of;
+				continue;
+			}
+			else if (is_hrule(block, rest))
+				size_of = atxheader_end(block, rest) + 1;
+			else if ((size_of = fencedcode_end(block, rest)) != 0)
+				;
+			else if (prefix_quote(block, rest))
+				size_of = blockquote_end(block, rest);
+			else if (prefix_code(block, rest))
+				size_of = blockcode_end(block, rest);
+			else if (prefix_uli(block, rest) || prefix_oli(block, rest)) {
+				auto list    = list_end_of(block, rest, !prefix_uli(block, rest));
+				size_of      = list.size;
+				ends_at_item = list.at_item;
+			}
+			else
+				size_of = paragraph_end(block, rest);
+
+			auto start = line_at(beg);
+			auto after = beg > 0 && start > 0 && is_empty(bytes + lines[start - 1].text, length - lines[start - 1].text);
+
+			if (!started || (after && !joined)) {
+				finish();
+				first   = start;
+				started = true;
+			}
+
+			// a run keeps the empty lines that its last block takes in, since they can matter to the block:
+			// a fenced code block inside a quote that is not closed runs on to the end of the quote
+
+			beg    = std::min(beg + size_of, length);
+			last   = line_at(beg - 1) + 1;
+			joined = ends_at_item;
+		}
+
+		// and the last run keeps the empty lines at the end of the document, which are part of a fenced code block that is not closed
+
+		last = lines.size();
+		finish();
+
+		result.usable = true;
+		return result;
+	}
+
+
+	/// Find the ids of the link references that a run may use.
+	/// Links give ids between brackets, which hoedown compares ignoring case and with each line break read as a space.
+	/// @param	data	The run.
+	/// @param	size	The size of the run.
+	/// @param	ids		Filled with lower-cased ids.
+	/// @return			False if the ids cannot be found this way (they contain tabs, which hoedown expands) and the run may use any reference.
+	inline bool link_ids(const char* data, size_t size, std::unordered_set<std::string>& ids) {
+		std::string id;
+
+		for (auto open = static_cast<const char*>(std::memchr(data, '[', size)); open; open = static_cast<const char*>(std::memchr(open + 1, '[', data + size - open - 1))) {
+			char previous = 0;
+
+			id.clear();
+			for (auto p = open + 1; p < data + size && *p != ']'; ++p) {
+				if (*p == '\t')
+					return false;
+				if (*p == '\r' && p + 1 < data + size && p[1] == '\n')
+					continue;
+				if (*p != '\n')
+					id += static_cast<char>(std::tolower(static_cast<unsigned char>(*p)));
+				else if (previous != ' ')
+					id += ' ';
+				previous = *p;
+			}
+			ids.insert(id);
+		}
+		return true;
+	}
+
+}    // namespace block_splitter
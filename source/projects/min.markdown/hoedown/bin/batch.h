@@ -0,0 +1,512 @@
+/* batch.h - render many files at once on a pool of threads */
+
+#include "document.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define BATCH_MAX_JOBS 64
+#define BATCH_ARENA_SIZE (64 * 1024)
+
+
+/* PLATFORM */
+
+#ifdef _WIN32
+
+typedef HANDLE batch_thread;
+typedef CRITICAL_SECTION batch_mutex;
+
+#define batch_mutex_init(m) InitializeCriticalSection(m)
+#define batch_mutex_lock(m) EnterCriticalSection(m)
+#define batch_mutex_unlock(m) LeaveCriticalSection(m)
+#define batch_mutex_destroy(m) DeleteCriticalSection(m)
+
+static const char batch_separators[] = "/\\";
+
+/* seconds since an arbitrary point, from a clock that measures real time */
+double
+batch_now(void)
+{
+	LARGE_INTEGER count, frequency;
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&frequency);
+	return (double)count.QuadPart / (double)frequency.QuadPart;
+}
+
+long
+batch_processors(void)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (long)info.dwNumberOfProcessors;
+}
+
+int
+batch_is_directory(const char *path)
+{
+	DWORD attributes = GetFileAttributesA(path);
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+/* replace a file with another in one step, so that no reader sees a partly written file */
+int
+batch_replace(const char *from, const char *to)
+{
+	return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+}
+
+#else
+
+typedef pthread_t batch_thread;
+typedef pthread_mutex_t batch_mutex;
+
+#define batch_mutex_init(m) pthread_mutex_init(m, NULL)
+#define batch_mutex_lock(m) pthread_mutex_lock(m)
+#define batch_mutex_unlock(m) pthread_mutex_unlock(m)
+#define batch_mutex_destroy(m) pthread_mutex_destroy(m)
+
+static const char batch_separators[] = "/";
+
+double
+batch_now(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+long
+batch_processors(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	return sysconf(_SC_NPROCESSORS_ONLN);
+#else
+	return 1;
+#endif
+}
+
+int
+batch_is_directory(const char *path)
+{
+	struct stat status;
+	return stat(path, &status) == 0 && S_ISDIR(status.st_mode);
+}
+
+int
+batch_replace(const char *from, const char *to)
+{
+	return rename(from, to);
+}
+
+#endif
+
+
+/* FILE LIST */
+
+struct batch_file {
+	char *input;
+	char *output;
+
+	/* results, written by the worker that renders the file */
+	size_t size;
+	double seconds;
+	int error;
+};
+
+struct batch {
+	struct batch_file *files;
+	size_t count;
+	size_t capacity;
+
+	/* rendering, shared by every worker */
+	hoedown_renderer *(*renderer_new)(void *opaque);
+	void (*renderer_free)(hoedown_renderer *renderer);
+	void *opaque;
+	hoedown_extensions extensions;
+	size_t max_nesting;
+	size_t iunit;
+	size_t ounit;
+
+	/* the next file to render */
+	batch_mutex mutex;
+	size_t next;
+};
+
+char *
+batch_strdup(const char *s)
+{
+	char *copy = malloc(strlen(s) + 1);
+	if (copy) strcpy(copy, s);
+	return copy;
+}
+
+int
+batch_has_extension(const char *path, const char *extension)
+{
+	size_t length = strlen(path), extension_length = strlen(extension);
+	return length > extension_length && strcmp(path + length - extension_length, extension) == 0;
+}
+
+int
+batch_is_markdown(const char *path)
+{
+	return batch_has_extension(path, ".md") || batch_has_extension(path, ".markdown");
+}
+
+/* the output for an input: the same name with an .html extension, in output_dir or next to the input */
+char *
+batch_output_path(const char *input, const char *output_dir)
+{
+	const char *name = input, *p, *dot;
+	size_t dir_length = 0, stem_length;
+	char *output;
+
+	for (p = input; *p; p++)
+		if (strchr(batch_separators, *p))
+			name = p + 1;
+
+	dot = strrchr(name, '.');
+	stem_length = (dot && dot != name) ? (size_t)(dot - input) : strlen(input);
+
+	if (output_dir) {
+		dir_length = strlen(output_dir);
+		stem_length -= name - input;
+	} else
+		name = input;
+
+	output = malloc(dir_length + 1 + stem_length + sizeof(".html"));
+	if (!output) return NULL;
+
+	output[0] = '\0';
+	if (output_dir) {
+		strcpy(output, output_dir);
+		if (dir_length && !strchr(batch_separators, output_dir[dir_length - 1]))
+			strcat(output, "/");
+	}
+	strncat(output, name, stem_length);
+	strcat(output, ".html");
+	return output;
+}
+
+int
+batch_add_file(struct batch *batch, const char *input, const char *output_dir)
+{
+	struct batch_file *file;
+
+	if (batch->count == batch->capacity) {
+		size_t capacity = batch->capacity ? batch->capacity * 2 : 64;
+		struct batch_file *files = realloc(batch->files, capacity * sizeof(struct batch_file));
+		if (!files) return 0;
+		batch->files = files;
+		batch->capacity = capacity;
+	}
+
+	file = &batch->files[batch->count];
+	file->input = batch_strdup(input);
+	file->output = batch_output_path(input, output_dir);
+	file->size = 0;
+	file->seconds = 0;
+	file->error = 0;
+	if (!file->input || !file->output) {
+		free(file->input);
+		free(file->output);
+		return 0;
+	}
+
+	if (strcmp(file->input, file->output) == 0) {
+		fprintf(stderr, "The output for \"%s\" would replace it.\n", input);
+		free(file->input);
+		free(file->output);
+		return 0;
+	}
+
+	batch->count++;
+	return 1;
+}
+
+int
+batch_compare_files(const void *a, const void *b)
+{
+	return strcmp(((const struct batch_file *)a)->input, ((const struct batch_file *)b)->input);
+}
+
+/* add the Markdown files (.md or .markdown) in a directory in order of name, not looking in its subdirectories */
+int
+batch_add_directory(struct batch *batch, const char *directory, const char *output_dir)
+{
+	size_t length = strlen(directory), first = batch->count;
+	int ok = 1;
+	char *path;
+
+#ifdef _WIN32
+	WIN32_FIND_DATAA found;
+	HANDLE search;
+	char *pattern = malloc(length + 3);
+
+	if (!pattern) return 0;
+	sprintf(pattern, "%s\\*", directory);
+	search = FindFirstFileA(pattern, &found);
+	free(pattern);
+	if (search == INVALID_HANDLE_VALUE) {
+		fprintf(stderr, "Unable to open input directory \"%s\".\n", directory);
+		return 0;
+	}
+
+	do {
+		const char *name = found.cFileName;
+#else
+	struct dirent *entry;
+	DIR *dir = opendir(directory);
+
+	if (!dir) {
+		fprintf(stderr, "Unable to open input directory \"%s\": %s\n", directory, strerror(errno));
+		return 0;
+	}
+
+	while (ok && (entry = readdir(dir))) {
+		const char *name = entry->d_name;
+#endif
+		if (!batch_is_markdown(name))
+			continue;
+
+		path = malloc(length + 1 + strlen(name) + 1);
+		if (!path) {
+			ok = 0;
+			break;
+		}
+		sprintf(path, "%s/%s", directory, name);
+		if (!batch_is_directory(path))
+			ok = batch_add_file(batch, path, output_dir);
+		free(path);
+#ifdef _WIN32
+	} while (ok && FindNextFileA(search, &found));
+	FindClose(search);
+#else
+	}
+	closedir(dir);
+#endif
+
+	qsort(batch->files + first, batch->count - first, sizeof(struct batch_file), batch_compare_files);
+	return ok;
+}
+
+/* add a file, the Markdown files in a directory, or the paths listed one per line on standard input for '-' */
+int
+batch_add_path(struct batch *batch, const char *path, const char *output_dir)
+{
+	if (strcmp(path, "-") == 0) {
+		char line[4096];
+
+		while (fgets(line, sizeof(line), stdin)) {
+			size_t length = strlen(line);
+			while (length && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+				line[--length] = '\0';
+			if (length && !batch_add_path(batch, line, output_dir))
+				return 0;
+		}
+		return 1;
+	}
+
+	if (batch_is_directory(path))
+		return batch_add_directory(batch, path, output_dir);
+
+	return batch_add_file(batch, path, output_dir);
+}
+
+
+/* WORKERS */
+
+/* write a rendering next to its destination and then move it into place */
+int
+batch_write(const char *output, const hoedown_buffer *ob, int worker)
+{
+	char *temporary = malloc(strlen(output) + 32);
+	FILE *file;
+	int ok;
+
+	if (!temporary) return 0;
+	sprintf(temporary, "%s.%d.tmp", output, worker);
+
+	file = fopen(temporary, "wb");
+	if (!file) {
+		free(temporary);
+		return 0;
+	}
+
+	ok = fwrite(ob->data, 1, ob->size, file) == ob->size;
+	ok = (fclose(file) == 0) && ok;
+	ok = ok && batch_replace(temporary, output) == 0;
+	if (!ok)
+		remove(temporary);
+
+	free(temporary);
+	return ok;
+}
+
+struct batch_worker {
+	struct batch *batch;
+	int index;
+};
+
+/* Each worker has its own renderer, document and buffers, and takes files from the list until there are none left */
+#ifdef _WIN32
+DWORD WINAPI
+#else
+void *
+#endif
+batch_work(void *opaque)
+{
+	struct batch_worker *worker = opaque;
+	struct batch *batch = worker->batch;
+	hoedown_renderer *renderer = batch->renderer_new(batch->opaque);
+	hoedown_document *document = hoedown_document_new_arena(renderer, batch->extensions, batch->max_nesting, BATCH_ARENA_SIZE);
+	hoedown_buffer *ib = hoedown_buffer_new(batch->iunit);
+	hoedown_buffer *ob = hoedown_buffer_new(batch->ounit);
+
+	while (1) {
+		struct batch_file *file;
+		FILE *in;
+		double t1;
+
+		batch_mutex_lock(&batch->mutex);
+		file = batch->next < batch->count ? &batch->files[batch->next++] : NULL;
+		batch_mutex_unlock(&batch->mutex);
+
+		if (!file)
+			break;
+
+		errno = 0;
+		in = fopen(file->input, "rb");
+		if (!in) {
+			file->error = errno ? errno : EIO;
+			continue;
+		}
+
+		ib->size = 0;
+		if (hoedown_buffer_putf(ib, in)) {
+			fclose(in);
+			file->error = EIO;
+			continue;
+		}
+		fclose(in);
+
+		ob->size = 0;
+		t1 = batch_now();
+		hoedown_document_render(document, ob, ib->data, ib->size);
+		file->seconds = batch_now() - t1;
+		file->size = ib->size;
+
+		errno = 0;
+		if (!batch_write(file->output, ob, worker->index))
+			file->error = errno ? errno : EIO;
+	}
+
+	hoedown_buffer_free(ib);
+	hoedown_buffer_free(ob);
+	hoedown_document_free(document);
+	batch->renderer_free(renderer);
+	return 0;
+}
+
+
+/* MAIN LOGIC */
+
+/* Render every file of a batch on jobs threads, then report the time taken for each and the throughput.
+ * Returns 0 if every file was rendered, or 5 if any could not be read or written. */
+int
+batch_run(struct batch *batch, long jobs)
+{
+	batch_thread threads[BATCH_MAX_JOBS];
+	struct batch_worker workers[BATCH_MAX_JOBS];
+	size_t i, rendered = 0, total_size = 0;
+	double total_seconds = 0, t1, elapsed;
+	int j, result = 0;
+
+	if (jobs < 1)
+		jobs = batch_processors();
+	if (jobs < 1)
+		jobs = 1;
+	if (jobs > BATCH_MAX_JOBS)
+		jobs = BATCH_MAX_JOBS;
+	if ((size_t)jobs > batch->count)
+		jobs = batch->count ? (long)batch->count : 1;
+
+	batch_mutex_init(&batch->mutex);
+	batch->next = 0;
+
+	t1 = batch_now();
+	for (j = 0; j < jobs; ++j) {
+		workers[j].batch = batch;
+		workers[j].index = j;
+#ifdef _WIN32
+		threads[j] = CreateThread(NULL, 0, batch_work, &workers[j], 0, NULL);
+#else
+		pthread_create(&threads[j], NULL, batch_work, &workers[j]);
+#endif
+	}
+
+	for (j = 0; j < jobs; ++j) {
+#ifdef _WIN32
+		WaitForSingleObject(threads[j], INFINITE);
+		CloseHandle(threads[j]);
+#else
+		pthread_join(threads[j], NULL);
+#endif
+	}
+	elapsed = batch_now() - t1;
+
+	batch_mutex_destroy(&batch->mutex);
+
+	/* report */
+	printf("%10s %10s %10s  %s\n", "KB", "ms", "MB/s", "file");
+
+	for (i = 0; i < batch->count; ++i) {
+		struct batch_file *file = &batch->files[i];
+
+		if (file->error) {
+			fprintf(stderr, "Unable to render \"%s\" to \"%s\": %s\n", file->input, file->output, strerror(file->error));
+			result = 5;
+			continue;
+		}
+
+		printf("%10.1f %10.3f %10.1f  %s\n",
+			file->size / 1024.0, file->seconds * 1e3,
+			file->seconds > 0 ? file->size / file->seconds / (1024.0 * 1024.0) : 0.0,
+			file->input);
+
+		rendered++;
+		total_size += file->size;
+		total_seconds += file->seconds;
+	}
+
+	printf("\n%lu of %lu files, %.1f KB, %ld threads: %.3f ms rendering (%.1f MB/s), %.3f ms in all (%.1f MB/s)\n",
+		(unsigned long)rendered, (unsigned long)batch->count, total_size / 1024.0, jobs,
+		total_seconds * 1e3, total_seconds > 0 ? total_size / total_seconds / (1024.0 * 1024.0) : 0.0,
+		elapsed * 1e3, elapsed > 0 ? total_size / elapsed / (1024.0 * 1024.0) : 0.0);
+
+	return result;
+}
+
+void
+batch_free(struct batch *batch)
+{
+	size_t i;
+
+	for (i = 0; i < batch->count; ++i) {
+		free(batch->files[i].input);
+		free(batch->files[i].output);
+	}
+	free(batch->files);
+}
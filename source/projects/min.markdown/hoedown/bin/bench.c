@@ -0,0 +1,176 @@
+#include "document.h"
+#include "html.h"
+
+#include "common.h"
+#include <time.h>
+
+#define DEF_ITERATIONS 20
+#define DEF_COPIES 1
+#define DEF_ARENA_SIZE (64 * 1024)
+#define DEF_OUNIT 64
+#define DEF_MAX_NESTING 16
+
+#define BENCH_EXTENSIONS (HOEDOWN_EXT_BLOCK | HOEDOWN_EXT_SPAN)
+
+/* The ways of allocating that are compared */
+enum bench_mode {
+	MODE_HEAP,	/* a new document for every render, as the hoedown tool does */
+	MODE_HEAP_REUSED,	/* one document reused, keeping its work buffers between renders */
+	MODE_ARENA	/* one document reused, with its work buffers in an arena reset after every render */
+};
+
+static const char *mode_names[] = {
+	"heap",
+	"heap, reused",
+	"arena"
+};
+
+void
+print_help(const char *basename)
+{
+	printf("Usage: %s [OPTION]... FILE...\n\n", basename);
+	printf("Render each Markdown FILE repeatedly, with the work buffers allocated on the heap and in an arena, and report the time taken.\n\n");
+	print_option('n', "iterations=N", "Number of times each file is rendered in each mode. Default is " str(DEF_ITERATIONS) ".");
+	print_option('x', "copies=N", "Render N copies of each file as a single document, to make a large one. Default is " str(DEF_COPIES) ".");
+	print_option('h', "help", "Print this help text.");
+	print_option('v', "version", "Print Hoedown version.");
+}
+
+static hoedown_buffer *
+read_file(const char *path, long copies)
+{
+	hoedown_buffer *file, *doc;
+	FILE *in;
+	long i;
+
+	in = fopen(path, "rb");
+	if (!in) {
+		fprintf(stderr, "Unable to open input file \"%s\": %s\n", path, strerror(errno));
+		return NULL;
+	}
+
+	file = hoedown_buffer_new(1024);
+	if (hoedown_buffer_putf(file, in)) {
+		fprintf(stderr, "I/O errors found while reading input.\n");
+		fclose(in);
+		hoedown_buffer_free(file);
+		return NULL;
+	}
+	fclose(in);
+
+	doc = hoedown_buffer_new(1024);
+	hoedown_buffer_grow(doc, file->size * copies + copies);
+	for (i = 0; i < copies; ++i) {
+		hoedown_buffer_put(doc, file->data, file->size);
+		hoedown_buffer_putc(doc, '\n');
+	}
+
+	hoedown_buffer_free(file);
+	return doc;
+}
+
+/* Render a document in a mode, returning the seconds taken; the last output is left in ob */
+static double
+bench(enum bench_mode mode, const hoedown_buffer *in, hoedown_buffer *ob, long iterations)
+{
+	hoedown_renderer *renderer = hoedown_html_renderer_new(0, 0);
+	hoedown_document *document = NULL;
+	clock_t t1, t2;
+	long i;
+
+	if (mode == MODE_HEAP_REUSED)
+		document = hoedown_document_new(renderer, BENCH_EXTENSIONS, DEF_MAX_NESTING);
+	else if (mode == MODE_ARENA)
+		document = hoedown_document_new_arena(renderer, BENCH_EXTENSIONS, DEF_MAX_NESTING, DEF_ARENA_SIZE);
+
+	t1 = clock();
+	for (i = 0; i < iterations; ++i) {
+		ob->size = 0;
+
+		if (mode == MODE_HEAP) {
+			document = hoedown_document_new(renderer, BENCH_EXTENSIONS, DEF_MAX_NESTING);
+			hoedown_document_render(document, ob, in->data, in->size);
+			hoedown_document_free(document);
+			document = NULL;
+		} else
+			hoedown_document_render(document, ob, in->data, in->size);
+	}
+	t2 = clock();
+
+	if (document)
+		hoedown_document_free(document);
+	hoedown_html_renderer_free(renderer);
+
+	return (double)(t2 - t1) / CLOCKS_PER_SEC;
+}
+
+int
+main(int argc, char **argv)
+{
+	long iterations = DEF_ITERATIONS, copies = DEF_COPIES;
+	int i, mode, result = 0;
+
+	for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; ++i) {
+		const char *arg = argv[i];
+
+		if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+			print_help(argv[0]);
+			return 0;
+		} else if (strcmp(arg, "-v") == 0 || strcmp(arg, "--version") == 0) {
+			print_version();
+			return 0;
+		} else if ((strcmp(arg, "-n") == 0 && i + 1 < argc && parseint(argv[++i], &iterations)) ||
+				(strprefix(arg, "--iterations=") && parseint(strprefix(arg, "--iterations="), &iterations))) {
+			continue;
+		} else if ((strcmp(arg, "-x") == 0 && i + 1 < argc && parseint(argv[++i], &copies)) ||
+				(strprefix(arg, "--copies=") && parseint(strprefix(arg, "--copies="), &copies))) {
+			continue;
+		} else {
+			fprintf(stderr, "Wrong option '%s' found.\n", arg);
+			return 1;
+		}
+	}
+
+	if (i == argc || iterations < 1 || copies < 1) {
+		print_help(argv[0]);
+		return 1;
+	}
+
+	printf("%-40s %10s %-14s %10s %10s\n", "file", "size (KB)", "mode", "ms/render", "MB/s");
+
+	for (; i < argc; ++i) {
+		hoedown_buffer *in = read_file(argv[i], copies);
+		hoedown_buffer *expected, *ob;
+
+		if (!in) {
+			result = 5;
+			continue;
+		}
+
+		expected = hoedown_buffer_new(DEF_OUNIT);
+		ob = hoedown_buffer_new(DEF_OUNIT);
+
+		for (mode = MODE_HEAP; mode <= MODE_ARENA; ++mode) {
+			double seconds = bench((enum bench_mode)mode, in, ob, iterations);
+
+			printf("%-40s %10.1f %-14s %10.3f %10.1f\n",
+				argv[i], in->size / 1024.0, mode_names[mode],
+				seconds * 1000.0 / iterations,
+				seconds > 0 ? in->size * (double)iterations / seconds / (1024.0 * 1024.0) : 0.0);
+
+			/* every mode must render the same HTML */
+			if (mode == MODE_HEAP)
+				hoedown_buffer_set(expected, ob->data, ob->size);
+			else if (!hoedown_buffer_eq(expected, ob->data, ob->size)) {
+				fprintf(stderr, "The %s rendering of \"%s\" differs.\n", mode_names[mode], argv[i]);
+				result = 6;
+			}
+		}
+
+		hoedown_buffer_free(expected);
+		hoedown_buffer_free(ob);
+		hoedown_buffer_free(in);
+	}
+
+	return result;
+}
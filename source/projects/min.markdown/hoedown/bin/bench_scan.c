@@ -0,0 +1,207 @@
+#include "escape.h"
+#include "scan.h"
+
+#include "common.h"
+#include <time.h>
+
+#define DEF_ITERATIONS 200
+
+/* the bytes that the inline parser acts on with the HTML renderer and no extensions */
+static const char ACTIVE_CHARS[] = "*_`\n[!<\\&";
+
+void
+print_help(const char *basename)
+{
+	printf("Usage: %s [OPTION]... FILE...\n\n", basename);
+	printf("Time the scans for bytes to escape and for active Markdown characters over each FILE, byte by byte and with hoedown_charset_find.\n\n");
+	print_option('n', "iterations=N", "Number of times each file is scanned. Default is " str(DEF_ITERATIONS) ".");
+	print_option('h', "help", "Print this help text.");
+	print_option('v', "version", "Print Hoedown version.");
+}
+
+/* The byte by byte loops that hoedown_charset_find replaces */
+
+static void
+escape_html_bytewise(hoedown_buffer *ob, const uint8_t *data, size_t size, const uint8_t *table)
+{
+	size_t i = 0, mark;
+
+	while (1) {
+		mark = i;
+		while (i < size && table[data[i]] == 0) i++;
+
+		if (i > mark)
+			hoedown_buffer_put(ob, data + mark, i - mark);
+
+		if (i >= size) break;
+
+		/* the escapes themselves are the same either way, so only the scan is compared */
+		hoedown_buffer_putc(ob, data[i]);
+		i++;
+	}
+}
+
+static size_t
+count_active_bytewise(const uint8_t *data, size_t size, const uint8_t *table)
+{
+	size_t end = 0, count = 0;
+
+	while (end < size) {
+		while (end < size && table[data[end]] == 0)
+			end++;
+		if (end < size) {
+			count++;
+			end++;
+		}
+	}
+	return count;
+}
+
+static void
+escape_html_charset(hoedown_buffer *ob, const uint8_t *data, size_t size, const hoedown_charset *set)
+{
+	size_t i = 0, mark;
+
+	while (1) {
+		mark = i;
+		i += hoedown_charset_find(set, data + i, size - i);
+
+		if (i > mark)
+			hoedown_buffer_put(ob, data + mark, i - mark);
+
+		if (i >= size) break;
+
+		hoedown_buffer_putc(ob, data[i]);
+		i++;
+	}
+}
+
+static size_t
+count_active_charset(const uint8_t *data, size_t size, const hoedown_charset *set)
+{
+	size_t end = 0, count = 0;
+
+	while (end < size) {
+		end += hoedown_charset_find(set, data + end, size - end);
+		if (end < size) {
+			count++;
+			end++;
+		}
+	}
+	return count;
+}
+
+static void
+report(const char *file, const char *scan, size_t size, long iterations, clock_t t1, clock_t t2)
+{
+	double seconds = (double)(t2 - t1) / CLOCKS_PER_SEC;
+
+	printf("%-40s %-20s %10.3f %10.1f\n", file, scan,
+		seconds * 1000.0 / iterations,
+		seconds > 0 ? size * (double)iterations / seconds / (1024.0 * 1024.0) : 0.0);
+}
+
+int
+main(int argc, char **argv)
+{
+	static const uint8_t ESCAPE_CHARS[] = "\"&'/<>";
+
+	uint8_t escape_table[256], active_table[256];
+	hoedown_charset escape_set, active_set;
+	long iterations = DEF_ITERATIONS, n;
+	int i, result = 0;
+	size_t k;
+
+	for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; ++i) {
+		const char *arg = argv[i];
+
+		if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+			print_help(argv[0]);
+			return 0;
+		} else if (strcmp(arg, "-v") == 0 || strcmp(arg, "--version") == 0) {
+			print_version();
+			return 0;
+		} else if ((strcmp(arg, "-n") == 0 && i + 1 < argc && parseint(argv[++i], &iterations)) ||
+				(strprefix(arg, "--iterations=") && parseint(strprefix(arg, "--iterations="), &iterations))) {
+			continue;
+		} else {
+			fprintf(stderr, "Wrong option '%s' found.\n", arg);
+			return 1;
+		}
+	}
+
+	if (i == argc || iterations < 1) {
+		print_help(argv[0]);
+		return 1;
+	}
+
+	memset(escape_table, 0, sizeof(escape_table));
+	for (k = 0; k < sizeof(ESCAPE_CHARS) - 1; ++k)
+		escape_table[ESCAPE_CHARS[k]] = 1;
+	hoedown_charset_init(&escape_set, escape_table);
+
+	memset(active_table, 0, sizeof(active_table));
+	for (k = 0; k < sizeof(ACTIVE_CHARS) - 1; ++k)
+		active_table[(uint8_t)ACTIVE_CHARS[k]] = 1;
+	hoedown_charset_init(&active_set, active_table);
+
+	printf("%-40s %-20s %10s %10s\n", "file", "scan", "ms/scan", "MB/s");
+
+	for (; i < argc; ++i) {
+		hoedown_buffer *in = hoedown_buffer_new(1024);
+		hoedown_buffer *expected = hoedown_buffer_new(1024);
+		hoedown_buffer *ob = hoedown_buffer_new(1024);
+		size_t expected_count = 0, count = 0;
+		clock_t t1, t2;
+		FILE *file = fopen(argv[i], "rb");
+
+		if (!file || hoedown_buffer_putf(in, file)) {
+			fprintf(stderr, "Unable to read input file \"%s\".\n", argv[i]);
+			if (file)
+				fclose(file);
+			result = 5;
+			goto next;
+		}
+		fclose(file);
+
+		t1 = clock();
+		for (n = 0; n < iterations; ++n) {
+			expected->size = 0;
+			escape_html_bytewise(expected, in->data, in->size, escape_table);
+		}
+		t2 = clock();
+		report(argv[i], "escape, bytewise", in->size, iterations, t1, t2);
+
+		t1 = clock();
+		for (n = 0; n < iterations; ++n) {
+			ob->size = 0;
+			escape_html_charset(ob, in->data, in->size, &escape_set);
+		}
+		t2 = clock();
+		report(argv[i], "escape, charset", in->size, iterations, t1, t2);
+
+		t1 = clock();
+		for (n = 0; n < iterations; ++n)
+			expected_count += count_active_bytewise(in->data, in->size, active_table);
+		t2 = clock();
+		report(argv[i], "active, bytewise", in->size, iterations, t1, t2);
+
+		t1 = clock();
+		for (n = 0; n < iterations; ++n)
+			count += count_active_charset(in->data, in->size, &active_set);
+		t2 = clock();
+		report(argv[i], "active, charset", in->size, iterations, t1, t2);
+
+		if (!hoedown_buffer_eq(expected, ob->data, ob->size) || count != expected_count) {
+			fprintf(stderr, "The scans of \"%s\" differ.\n", argv[i]);
+			result = 6;
+		}
+
+	next:
+		hoedown_buffer_free(in);
+		hoedown_buffer_free(expected);
+		hoedown_buffer_free(ob);
+	}
+
+	return result;
+}
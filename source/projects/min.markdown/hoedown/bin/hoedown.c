@@ -1,7 +1,12 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "document.h"
 #include "html.h"
 
 #include "common.h"
+#include "batch.h"
 #include <time.h>
 
 
@@ -81,7 +86,8 @@ print_help(const char *basename)
 	size_t e;
 
 	/* usage */
-	printf("Usage: %s [OPTION]... [FILE]\n\n", basename);
+	printf("Usage: %s [OPTION]... [FILE]\n", basename);
+	printf("  or:  %s [OPTION]... --batch FILE|DIR...\n\n", basename);
 
 	/* description */
 	printf("Process the Markdown in FILE (or standard input) and render it to standard output, using the Hoedown library. "
@@ -96,6 +102,9 @@ print_help(const char *basename)
 	print_option('T', "time", "Show time spent in rendering.");
 	print_option('i', "input-unit=N", "Reading block size. Default is " str(DEF_IUNIT) ".");
 	print_option('o', "output-unit=N", "Writing block size. Default is " str(DEF_OUNIT) ".");
+	print_option('B', "batch", "Render every FILE, and the .md and .markdown files in every DIR, to an .html file of the same name.");
+	print_option('j', "jobs=N", "Number of files rendered at once in batch mode. Default is the number of processors.");
+	print_option('O', "output-dir=DIR", "Write the .html files of batch mode to DIR instead of next to each input.");
 	print_option('h', "help", "Print this help text.");
 	print_option('v', "version", "Print Hoedown version.");
 	printf("\n");
@@ -127,6 +136,10 @@ print_help(const char *basename)
 
 	printf("When FILE is '-', read standard input. If no FILE was given, read standard input. Use '--' to signal end of option parsing. "
 	       "Exit status is 0 if no errors occurred, 1 with option parsing errors, 4 with memory allocation errors or 5 with I/O errors.\n\n");
+
+	printf("In batch mode, a FILE of '-' reads the paths of the files to render from standard input, one per line. "
+	       "Files are rendered on several threads and each output is written in full before it replaces any earlier output. "
+	       "The size, rendering time and throughput of each file are written to standard output.\n\n");
 }
 
 
@@ -144,6 +157,13 @@ struct option_data {
 	size_t ounit;
 	const char *filename;
 
+	/* batch mode */
+	int batch;
+	long jobs;
+	const char *output_dir;
+	char **arguments;
+	int argument_count;
+
 	/* renderer */
 	enum renderer_type renderer;
 	int toc_level;
@@ -178,6 +198,16 @@ parse_short_option(char opt, char *next, void *opaque)
 		return 1;
 	}
 
+	if (opt == 'B') {
+		data->batch = 1;
+		return 1;
+	}
+
+	if (opt == 'O' && next) {
+		data->output_dir = next;
+		return 2;
+	}
+
 	/* options requiring value */
 	/* FIXME: add validation */
 
@@ -201,6 +231,11 @@ parse_short_option(char opt, char *next, void *opaque)
 		return 2;
 	}
 
+	if (opt == 'j' && isNum) {
+		data->jobs = num;
+		return 2;
+	}
+
 	fprintf(stderr, "Wrong option '-%c' found.\n", opt);
 	return 0;
 }
@@ -305,6 +340,11 @@ parse_long_option(char *opt, char *next, void *opaque)
 		return 1;
 	}
 
+	if (strcmp(opt, "batch")==0) {
+		data->batch = 1;
+		return 1;
+	}
+
 	/* FIXME: validation */
 
 	if (strcmp(opt, "max-nesting")==0 && isNum) {
@@ -323,6 +363,14 @@ parse_long_option(char *opt, char *next, void *opaque)
 		data->ounit = num;
 		return 2;
 	}
+	if (strcmp(opt, "jobs")==0 && isNum) {
+		data->jobs = num;
+		return 2;
+	}
+	if (strcmp(opt, "output-dir")==0 && next) {
+		data->output_dir = next;
+		return 2;
+	}
 
 	if (strcmp(opt, "html")==0) {
 		data->renderer = RENDERER_HTML;
@@ -345,14 +393,66 @@ parse_argument(int argn, char *arg, int is_forced, void *opaque)
 {
 	struct option_data *data = opaque;
 
+	/* Input files, which are only checked once batch mode is known */
+	data->arguments[data->argument_count++] = arg;
+
 	if (argn == 0) {
-		/* Input file */
 		if (strcmp(arg, "-")!=0 || is_forced) data->filename = arg;
+	}
+
+	return 1;
+}
+
+
+/* RENDERER */
+
+hoedown_renderer *
+new_renderer(void *opaque)
+{
+	struct option_data *data = opaque;
+
+	switch (data->renderer) {
+		case RENDERER_HTML_TOC:
+			return hoedown_html_toc_renderer_new(data->toc_level);
+		case RENDERER_HTML:
+		default:
+			return hoedown_html_renderer_new(data->html_flags, data->toc_level);
+	};
+}
+
+
+/* BATCH MODE */
+
+int
+render_batch(struct option_data *data)
+{
+	struct batch batch;
+	int i, result;
+
+	memset(&batch, 0, sizeof(batch));
+	batch.renderer_new = new_renderer;
+	batch.renderer_free = hoedown_html_renderer_free;
+	batch.opaque = data;
+	batch.extensions = data->extensions;
+	batch.max_nesting = data->max_nesting;
+	batch.iunit = data->iunit;
+	batch.ounit = data->ounit;
+
+	if (!data->argument_count) {
+		fprintf(stderr, "No files to render in batch mode.\n");
 		return 1;
 	}
 
-	fprintf(stderr, "Too many arguments.\n");
-	return 0;
+	for (i = 0; i < data->argument_count; i++) {
+		if (!batch_add_path(&batch, data->arguments[i], data->output_dir)) {
+			batch_free(&batch);
+			return 5;
+		}
+	}
+
+	result = batch_run(&batch, data->jobs);
+	batch_free(&batch);
+	return result;
 }
 
 
@@ -376,16 +476,38 @@ main(int argc, char **argv)
 	data.iunit = DEF_IUNIT;
 	data.ounit = DEF_OUNIT;
 	data.filename = NULL;
+	data.batch = 0;
+	data.jobs = 0;
+	data.output_dir = NULL;
+	data.arguments = malloc(argc * sizeof(char *));
+	data.argument_count = 0;
 	data.renderer = RENDERER_HTML;
 	data.toc_level = 0;
 	data.html_flags = 0;
 	data.extensions = 0;
 	data.max_nesting = DEF_MAX_NESTING;
 
+	if (!data.arguments) {
+		fprintf(stderr, "Allocation failed.\n");
+		return 4;
+	}
+
 	argc = parse_options(argc, argv, parse_short_option, parse_long_option, parse_argument, &data);
 	if (data.done) return 0;
 	if (!argc) return 1;
 
+	if (data.batch) {
+		int result = render_batch(&data);
+		free(data.arguments);
+		return result;
+	}
+
+	if (data.argument_count > 1) {
+		fprintf(stderr, "Too many arguments.\n");
+		return 1;
+	}
+	free(data.arguments);
+
 	/* Open input file, if needed */
 	if (data.filename) {
 		file = fopen(data.filename, "r");
@@ -406,16 +528,8 @@ main(int argc, char **argv)
 	if (file != stdin) fclose(file);
 
 	/* Create the renderer */
-	switch (data.renderer) {
-		case RENDERER_HTML:
-			renderer = hoedown_html_renderer_new(data.html_flags, data.toc_level);
-			renderer_free = hoedown_html_renderer_free;
-			break;
-		case RENDERER_HTML_TOC:
-			renderer = hoedown_html_toc_renderer_new(data.toc_level);
-			renderer_free = hoedown_html_renderer_free;
-			break;
-	};
+	renderer = new_renderer(&data);
+	renderer_free = hoedown_html_renderer_free;
 
 	/* Perform Markdown rendering */
 	ob = hoedown_buffer_new(data.ounit);
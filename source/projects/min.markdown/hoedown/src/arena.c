@@ -0,0 +1,143 @@
+#include "arena.h"
+
+#include "buffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/* allocations are aligned for any of the types that hoedown stores */
+#define ARENA_ALIGN(size) (((size) + 15) & ~(size_t)15)
+
+struct hoedown_arena_block {
+	struct hoedown_arena_block *prev;
+	size_t size;	/* usable bytes after the header */
+	size_t used;
+};
+
+#define BLOCK_HEADER ARENA_ALIGN(sizeof(struct hoedown_arena_block))
+#define BLOCK_DATA(block) ((uint8_t *)(block) + BLOCK_HEADER)
+
+static struct hoedown_arena_block *
+new_block(struct hoedown_arena_block *prev, size_t size)
+{
+	struct hoedown_arena_block *block = hoedown_malloc(BLOCK_HEADER + size);
+
+	block->prev = prev;
+	block->size = size;
+	block->used = 0;
+	return block;
+}
+
+hoedown_arena *
+hoedown_arena_new(size_t block_size)
+{
+	hoedown_arena *arena = hoedown_malloc(sizeof(hoedown_arena));
+
+	arena->block_size = ARENA_ALIGN(block_size ? block_size : 4096);
+	arena->block = new_block(NULL, arena->block_size);
+	arena->last = NULL;
+	arena->allocated = 0;
+	return arena;
+}
+
+void *
+hoedown_arena_malloc(hoedown_arena *arena, size_t size)
+{
+	struct hoedown_arena_block *block;
+	uint8_t *ptr;
+
+	assert(arena);
+
+	size = ARENA_ALIGN(size);
+	block = arena->block;
+
+	if (block->used + size > block->size) {
+		/* leave the rest of this block unused; blocks grow with the arena so that there are few of them */
+		size_t neosz = arena->allocated > arena->block_size ? arena->allocated : arena->block_size;
+		if (neosz < size)
+			neosz = size;
+
+		block = arena->block = new_block(block, neosz);
+	}
+
+	ptr = BLOCK_DATA(block) + block->used;
+	block->used += size;
+	arena->allocated += size;
+	arena->last = ptr;
+	return ptr;
+}
+
+void *
+hoedown_arena_realloc(hoedown_arena *arena, void *ptr, size_t old_size, size_t size)
+{
+	struct hoedown_arena_block *block;
+	void *neoptr;
+
+	assert(arena);
+
+	if (!ptr)
+		return hoedown_arena_malloc(arena, size);
+
+	/* the most recent allocation is at the end of the current block and can simply be extended */
+	block = arena->block;
+	if (ptr == arena->last) {
+		size_t offset = arena->last - BLOCK_DATA(block);
+		size_t neoused = offset + ARENA_ALIGN(size);
+
+		if (neoused <= block->size) {
+			arena->allocated = arena->allocated - block->used + neoused;
+			block->used = neoused;
+			return ptr;
+		}
+	}
+
+	/* otherwise the old allocation is abandoned until the next reset */
+	neoptr = hoedown_arena_malloc(arena, size);
+	memcpy(neoptr, ptr, old_size < size ? old_size : size);
+	return neoptr;
+}
+
+void
+hoedown_arena_reset(hoedown_arena *arena)
+{
+	struct hoedown_arena_block *block;
+
+	assert(arena);
+
+	block = arena->block;
+
+	/* replace several blocks with one that holds everything, so the next use needs a single block */
+	if (block->prev) {
+		size_t size = 0;
+
+		while (block) {
+			struct hoedown_arena_block *prev = block->prev;
+			size += block->size;
+			free(block);
+			block = prev;
+		}
+		arena->block = new_block(NULL, size);
+	}
+
+	arena->block->used = 0;
+	arena->last = NULL;
+	arena->allocated = 0;
+}
+
+void
+hoedown_arena_free(hoedown_arena *arena)
+{
+	struct hoedown_arena_block *block;
+
+	if (!arena) return;
+
+	block = arena->block;
+	while (block) {
+		struct hoedown_arena_block *prev = block->prev;
+		free(block);
+		block = prev;
+	}
+
+	free(arena);
+}
@@ -0,0 +1,54 @@
+/* arena.h - region allocation for short-lived buffers */
+
+#ifndef HOEDOWN_ARENA_H
+#define HOEDOWN_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*********
+ * TYPES *
+ *********/
+
+struct hoedown_arena_block;
+
+struct hoedown_arena {
+	struct hoedown_arena_block *block;	/* block being allocated from, linked to the blocks before it */
+	size_t block_size;	/* minimum size of a new block */
+	uint8_t *last;	/* the most recent allocation, which can grow in place */
+	size_t allocated;	/* bytes allocated since the last reset */
+};
+
+typedef struct hoedown_arena hoedown_arena;
+
+
+/*************
+ * FUNCTIONS *
+ *************/
+
+/* hoedown_arena_new: allocate a new arena, taking memory from the heap block_size bytes at a time */
+hoedown_arena *hoedown_arena_new(size_t block_size) __attribute__ ((malloc));
+
+/* hoedown_arena_malloc: allocate memory that lasts until the arena is reset */
+void *hoedown_arena_malloc(hoedown_arena *arena, size_t size) __attribute__ ((malloc));
+
+/* hoedown_arena_realloc: resize an allocation keeping its first old_size bytes, in place if it is the most recent one */
+void *hoedown_arena_realloc(hoedown_arena *arena, void *ptr, size_t old_size, size_t size);
+
+/* hoedown_arena_reset: release every allocation at once, keeping the memory for reuse */
+void hoedown_arena_reset(hoedown_arena *arena);
+
+/* hoedown_arena_free: free the arena and all of its memory */
+void hoedown_arena_free(hoedown_arena *arena);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /** HOEDOWN_ARENA_H **/
@@ -60,13 +60,15 @@ hoedown_buffer_init(
 	buf->data_realloc = data_realloc;
 	buf->data_free = data_free;
 	buf->buffer_free = buffer_free;
+	buf->arena = NULL;
 }
 
 void
 hoedown_buffer_uninit(hoedown_buffer *buf)
 {
 	assert(buf && buf->unit);
-	buf->data_free(buf->data);
+	if (!buf->arena)
+		buf->data_free(buf->data);
 }
 
 hoedown_buffer *
@@ -77,12 +79,24 @@ hoedown_buffer_new(size_t unit)
 	return ret;
 }
 
+hoedown_buffer *
+hoedown_buffer_new_arena(size_t unit, hoedown_arena *arena)
+{
+	hoedown_buffer *ret = hoedown_arena_malloc(arena, sizeof (hoedown_buffer));
+	hoedown_buffer_init(ret, unit, NULL, NULL, NULL);
+	ret->arena = arena;
+	return ret;
+}
+
 void
 hoedown_buffer_free(hoedown_buffer *buf)
 {
 	if (!buf) return;
 	assert(buf && buf->unit);
 
+	/* memory from an arena is only released when the arena is reset */
+	if (buf->arena) return;
+
 	buf->data_free(buf->data);
 
 	if (buf->buffer_free)
@@ -94,7 +108,8 @@ hoedown_buffer_reset(hoedown_buffer *buf)
 {
 	assert(buf && buf->unit);
 
-	buf->data_free(buf->data);
+	if (!buf->arena)
+		buf->data_free(buf->data);
 	buf->data = NULL;
 	buf->size = buf->asize = 0;
 }
@@ -112,7 +127,13 @@ hoedown_buffer_grow(hoedown_buffer *buf, size_t neosz)
 	while (neoasz < neosz)
 		neoasz += buf->unit;
 
-	buf->data = buf->data_realloc(buf->data, neoasz);
+	if (buf->arena) {
+		/* grow geometrically, as a copy in an arena abandons the old allocation */
+		if (neoasz < buf->asize * 2)
+			neoasz = buf->asize * 2;
+		buf->data = hoedown_arena_realloc(buf->arena, buf->data, buf->size, neoasz);
+	} else
+		buf->data = buf->data_realloc(buf->data, neoasz);
 	buf->asize = neoasz;
 }
 
@@ -9,6 +9,8 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "arena.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -36,6 +38,8 @@ struct hoedown_buffer {
 	hoedown_realloc_callback data_realloc;
 	hoedown_free_callback data_free;
 	hoedown_free_callback buffer_free;
+
+	hoedown_arena *arena;	/* arena holding the data and the buffer itself, or NULL for the callbacks above */
 };
 
 typedef struct hoedown_buffer hoedown_buffer;
@@ -65,6 +69,9 @@ void hoedown_buffer_uninit(hoedown_buffer *buf);
 /* hoedown_buffer_new: allocate a new buffer */
 hoedown_buffer *hoedown_buffer_new(size_t unit) __attribute__ ((malloc));
 
+/* hoedown_buffer_new_arena: allocate a new buffer in an arena, freed when the arena is reset */
+hoedown_buffer *hoedown_buffer_new_arena(size_t unit, hoedown_arena *arena) __attribute__ ((malloc));
+
 /* hoedown_buffer_reset: free internal data of the buffer */
 void hoedown_buffer_reset(hoedown_buffer *buf);
 
@@ -6,6 +6,7 @@
 #include <stdio.h>
 
 #include "stack.h"
+#include "scan.h"
 
 #ifndef _MSC_VER
 #include <strings.h>
@@ -125,7 +126,9 @@ struct hoedown_document {
 	struct footnote_list footnotes_found;
 	struct footnote_list footnotes_used;
 	uint8_t active_char[256];
+	hoedown_charset active_set;	/* the bytes in active_char */
 	hoedown_stack work_bufs[2];
+	hoedown_arena *arena;	/* holds the memory used while rendering, or NULL */
 	hoedown_extensions ext_flags;
 	size_t max_nesting;
 	int in_link_body;
@@ -135,6 +138,35 @@ struct hoedown_document {
  * HELPER FUNCTIONS *
  ***************************/
 
+/* doc_buffer_new • a buffer that lasts for a render, from the arena if there is one */
+static hoedown_buffer *
+doc_buffer_new(hoedown_document *doc, size_t unit)
+{
+	return doc->arena ? hoedown_buffer_new_arena(unit, doc->arena) : hoedown_buffer_new(unit);
+}
+
+/* doc_calloc • zeroed memory that lasts for a render, from the arena if there is one */
+static void *
+doc_calloc(hoedown_document *doc, size_t nmemb, size_t size)
+{
+	void *ptr;
+
+	if (!doc->arena)
+		return hoedown_calloc(nmemb, size);
+
+	ptr = hoedown_arena_malloc(doc->arena, nmemb * size);
+	memset(ptr, 0x0, nmemb * size);
+	return ptr;
+}
+
+/* doc_free • free memory from doc_calloc; memory from the arena is released at the end of the render */
+static void
+doc_free(hoedown_document *doc, void *ptr)
+{
+	if (!doc->arena)
+		free(ptr);
+}
+
 static hoedown_buffer *
 newbuf(hoedown_document *doc, int type)
 {
@@ -147,7 +179,7 @@ newbuf(hoedown_document *doc, int type)
 		work = pool->item[pool->size++];
 		work->size = 0;
 	} else {
-		work = hoedown_buffer_new(buf_size[type]);
+		work = doc_buffer_new(doc, buf_size[type]);
 		hoedown_stack_push(pool, work);
 	}
 
@@ -160,6 +192,21 @@ popbuf(hoedown_document *doc, int type)
 	doc->work_bufs[type].size--;
 }
 
+/* release_arena • drop the work buffers and everything else allocated in the arena during a render */
+static void
+release_arena(hoedown_document *doc)
+{
+	hoedown_stack *span = &doc->work_bufs[BUFFER_SPAN];
+	hoedown_stack *block = &doc->work_bufs[BUFFER_BLOCK];
+
+	if (!doc->arena)
+		return;
+
+	memset(span->item, 0x0, span->asize * sizeof(void *));
+	memset(block->item, 0x0, block->asize * sizeof(void *));
+	hoedown_arena_reset(doc->arena);
+}
+
 static void
 unscape_text(hoedown_buffer *ob, hoedown_buffer *src)
 {
@@ -194,10 +241,11 @@ hash_link_ref(const uint8_t *link_ref, size_t length)
 
 static struct link_ref *
 add_link_ref(
+	hoedown_document *doc,
 	struct link_ref **references,
 	const uint8_t *name, size_t name_size)
 {
-	struct link_ref *ref = hoedown_calloc(1, sizeof(struct link_ref));
+	struct link_ref *ref = doc_calloc(doc, 1, sizeof(struct link_ref));
 
 	ref->id = hash_link_ref(name, name_size);
 	ref->next = references[ref->id % REF_TABLE_SIZE];
@@ -225,10 +273,13 @@ find_link_ref(struct link_ref **references, uint8_t *name, size_t length)
 }
 
 static void
-free_link_refs(struct link_ref **references)
+free_link_refs(hoedown_document *doc, struct link_ref **references)
 {
 	size_t i;
 
+	if (doc->arena)
+		return;
+
 	for (i = 0; i < REF_TABLE_SIZE; ++i) {
 		struct link_ref *r = references[i];
 		struct link_ref *next;
@@ -244,9 +295,9 @@ free_link_refs(struct link_ref **references)
 }
 
 static struct footnote_ref *
-create_footnote_ref(struct footnote_list *list, const uint8_t *name, size_t name_size)
+create_footnote_ref(hoedown_document *doc, struct footnote_list *list, const uint8_t *name, size_t name_size)
 {
-	struct footnote_ref *ref = hoedown_calloc(1, sizeof(struct footnote_ref));
+	struct footnote_ref *ref = doc_calloc(doc, 1, sizeof(struct footnote_ref));
 
 	ref->id = hash_link_ref(name, name_size);
 
@@ -254,9 +305,9 @@ create_footnote_ref(struct footnote_list *list, const uint8_t *name, size_t name
 }
 
 static int
-add_footnote_ref(struct footnote_list *list, struct footnote_ref *ref)
+add_footnote_ref(hoedown_document *doc, struct footnote_list *list, struct footnote_ref *ref)
 {
-	struct footnote_item *item = hoedown_calloc(1, sizeof(struct footnote_item));
+	struct footnote_item *item = doc_calloc(doc, 1, sizeof(struct footnote_item));
 	if (!item)
 		return 0;
 	item->ref = ref;
@@ -290,22 +341,25 @@ find_footnote_ref(struct footnote_list *list, uint8_t *name, size_t length)
 }
 
 static void
-free_footnote_ref(struct footnote_ref *ref)
+free_footnote_ref(hoedown_document *doc, struct footnote_ref *ref)
 {
 	hoedown_buffer_free(ref->contents);
-	free(ref);
+	doc_free(doc, ref);
 }
 
 static void
-free_footnote_list(struct footnote_list *list, int free_refs)
+free_footnote_list(hoedown_document *doc, struct footnote_list *list, int free_refs)
 {
 	struct footnote_item *item = list->head;
 	struct footnote_item *next;
 
+	if (doc->arena)
+		return;
+
 	while (item) {
 		next = item->next;
 		if (free_refs)
-			free_footnote_ref(item->ref);
+			free_footnote_ref(doc, item->ref);
 		free(item);
 		item = next;
 	}
@@ -477,7 +531,7 @@ static void
 parse_inline(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t size)
 {
 	size_t i = 0, end = 0, consumed = 0;
-	hoedown_buffer work = { 0, 0, 0, 0, NULL, NULL, NULL };
+	hoedown_buffer work = { 0, 0, 0, 0, NULL, NULL, NULL, NULL };
 	uint8_t *active_char = doc->active_char;
 
 	if (doc->work_bufs[BUFFER_SPAN].size +
@@ -486,8 +540,7 @@ parse_inline(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t si
 
 	while (i < size) {
 		/* copying inactive chars into the output */
-		while (end < size && active_char[data[end]] == 0)
-			end++;
+		end += hoedown_charset_find(&doc->active_set, data + end, size - end);
 
 		if (doc->md.normal_text) {
 			work.data = data + i;
@@ -735,7 +788,7 @@ parse_emph3(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t siz
 static size_t
 parse_math(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t offset, size_t size, const char *end, size_t delimsz, int displaymode)
 {
-	hoedown_buffer text = { NULL, 0, 0, 0, NULL, NULL, NULL };
+	hoedown_buffer text = { NULL, 0, 0, 0, NULL, NULL, NULL, NULL };
 	size_t i = delimsz;
 
 	if (!doc->md.math)
@@ -831,7 +884,7 @@ char_linebreak(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t
 static size_t
 char_codespan(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t offset, size_t size)
 {
-	hoedown_buffer work = { NULL, 0, 0, 0, NULL, NULL, NULL };
+	hoedown_buffer work = { NULL, 0, 0, 0, NULL, NULL, NULL, NULL };
 	size_t end, nb = 0, i, f_begin, f_end;
 
 	/* counting the number of backticks in the delimiter */
@@ -924,7 +977,7 @@ static size_t
 char_escape(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t offset, size_t size)
 {
 	static const char *escape_chars = "\\`*_{}[]()#+-.!:|&<>^~=\"$";
-	hoedown_buffer work = { 0, 0, 0, 0, NULL, NULL, NULL };
+	hoedown_buffer work = { 0, 0, 0, 0, NULL, NULL, NULL, NULL };
 	size_t w;
 
 	if (size > 1) {
@@ -962,7 +1015,7 @@ static size_t
 char_entity(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t offset, size_t size)
 {
 	size_t end = 1;
-	hoedown_buffer work = { 0, 0, 0, 0, NULL, NULL, NULL };
+	hoedown_buffer work = { 0, 0, 0, 0, NULL, NULL, NULL, NULL };
 
 	if (end < size && data[end] == '#')
 		end++;
@@ -989,7 +1042,7 @@ char_entity(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t off
 static size_t
 char_langle_tag(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t offset, size_t size)
 {
-	hoedown_buffer work = { NULL, 0, 0, 0, NULL, NULL, NULL };
+	hoedown_buffer work = { NULL, 0, 0, 0, NULL, NULL, NULL, NULL };
 	hoedown_autolink_type altype = HOEDOWN_AUTOLINK_NONE;
 	size_t end = tag_length(data, size, &altype);
 	int ret = 0;
@@ -1137,7 +1190,7 @@ char_link(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t offse
 
 	/* footnote link */
 	if (is_footnote) {
-		hoedown_buffer id = { NULL, 0, 0, 0, NULL, NULL, NULL };
+		hoedown_buffer id = { NULL, 0, 0, 0, NULL, NULL, NULL, NULL };
 		struct footnote_ref *fr;
 
 		if (txt_e < 3)
@@ -1150,7 +1203,7 @@ char_link(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t offse
 
 		/* mark footnote used */
 		if (fr && !fr->is_used) {
-			if(!add_footnote_ref(&doc->footnotes_used, fr))
+			if(!add_footnote_ref(doc, &doc->footnotes_used, fr))
 				goto cleanup;
 			fr->is_used = 1;
 			fr->num = doc->footnotes_used.count;
@@ -1678,7 +1731,7 @@ parse_htmlblock(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t
 static size_t
 parse_paragraph(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t size)
 {
-	hoedown_buffer work = { NULL, 0, 0, 0, NULL, NULL, NULL };
+	hoedown_buffer work = { NULL, 0, 0, 0, NULL, NULL, NULL, NULL };
 	size_t i = 0, end = 0;
 	int level = 0;
 
@@ -1758,8 +1811,8 @@ parse_paragraph(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t
 static size_t
 parse_fencedcode(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t size)
 {
-	hoedown_buffer text = { 0, 0, 0, 0, NULL, NULL, NULL };
-	hoedown_buffer lang = { 0, 0, 0, 0, NULL, NULL, NULL };
+	hoedown_buffer text = { 0, 0, 0, 0, NULL, NULL, NULL, NULL };
+	hoedown_buffer lang = { 0, 0, 0, 0, NULL, NULL, NULL, NULL };
 	size_t i = 0, text_start, line_start;
 	size_t w, w2;
 	size_t width, width2;
@@ -2154,7 +2207,7 @@ htmlblock_find_end_strict(
 static size_t
 parse_htmlblock(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t size, int do_render)
 {
-	hoedown_buffer work = { NULL, 0, 0, 0, NULL, NULL, NULL };
+	hoedown_buffer work = { NULL, 0, 0, 0, NULL, NULL, NULL, NULL };
 	size_t i, j = 0, tag_len, tag_end;
 	const char *curtag = NULL;
 
@@ -2292,7 +2345,7 @@ parse_table_row(
 	}
 
 	for (; col < columns; ++col) {
-		hoedown_buffer empty_cell = { 0, 0, 0, 0, NULL, NULL, NULL };
+		hoedown_buffer empty_cell = { 0, 0, 0, 0, NULL, NULL, NULL, NULL };
 		doc->md.table_cell(row_work, &empty_cell, col_data[col] | header_flag, &doc->data);
 	}
 
@@ -2336,7 +2389,7 @@ parse_table_header(
 		return 0;
 
 	*columns = pipes + 1;
-	*column_data = hoedown_calloc(*columns, sizeof(hoedown_table_flags));
+	*column_data = doc_calloc(doc, *columns, sizeof(hoedown_table_flags));
 
 	/* Parse the header underline */
 	i++;
@@ -2453,7 +2506,7 @@ parse_table(
 			doc->md.table(ob, work, &doc->data);
 	}
 
-	free(col_data);
+	doc_free(doc, col_data);
 	popbuf(doc, BUFFER_SPAN);
 	popbuf(doc, BUFFER_BLOCK);
 	popbuf(doc, BUFFER_BLOCK);
@@ -2529,7 +2582,7 @@ parse_block(hoedown_buffer *ob, hoedown_document *doc, uint8_t *data, size_t siz
 
 /* is_footnote • returns whether a line is a footnote definition or not */
 static int
-is_footnote(const uint8_t *data, size_t beg, size_t end, size_t *last, struct footnote_list *list)
+is_footnote(hoedown_document *doc, const uint8_t *data, size_t beg, size_t end, size_t *last, struct footnote_list *list)
 {
 	size_t i = 0;
 	hoedown_buffer *contents = 0;
@@ -2564,7 +2617,7 @@ is_footnote(const uint8_t *data, size_t beg, size_t end, size_t *last, struct fo
 	i++;
 
 	/* getting content buffer */
-	contents = hoedown_buffer_new(64);
+	contents = doc_buffer_new(doc, 64);
 
 	start = i;
 
@@ -2619,11 +2672,11 @@ is_footnote(const uint8_t *data, size_t beg, size_t end, size_t *last, struct fo
 
 	if (list) {
 		struct footnote_ref *ref;
-		ref = create_footnote_ref(list, data + id_offset, id_end - id_offset);
+		ref = create_footnote_ref(doc, list, data + id_offset, id_end - id_offset);
 		if (!ref)
 			return 0;
-		if (!add_footnote_ref(list, ref)) {
-			free_footnote_ref(ref);
+		if (!add_footnote_ref(doc, list, ref)) {
+			free_footnote_ref(doc, ref);
 			return 0;
 		}
 		ref->contents = contents;
@@ -2634,7 +2687,7 @@ is_footnote(const uint8_t *data, size_t beg, size_t end, size_t *last, struct fo
 
 /* is_ref • returns whether a line is a reference or not */
 static int
-is_ref(const uint8_t *data, size_t beg, size_t end, size_t *last, struct link_ref **refs)
+is_ref(hoedown_document *doc, const uint8_t *data, size_t beg, size_t end, size_t *last, struct link_ref **refs)
 {
 /*	int n; */
 	size_t i = 0;
@@ -2730,15 +2783,15 @@ is_ref(const uint8_t *data, size_t beg, size_t end, size_t *last, struct link_re
 	if (refs) {
 		struct link_ref *ref;
 
-		ref = add_link_ref(refs, data + id_offset, id_end - id_offset);
+		ref = add_link_ref(doc, refs, data + id_offset, id_end - id_offset);
 		if (!ref)
 			return 0;
 
-		ref->link = hoedown_buffer_new(link_end - link_offset);
+		ref->link = doc_buffer_new(doc, link_end - link_offset);
 		hoedown_buffer_put(ref->link, data + link_offset, link_end - link_offset);
 
 		if (title_end > title_offset) {
-			ref->title = hoedown_buffer_new(title_end - title_offset);
+			ref->title = doc_buffer_new(doc, title_end - title_offset);
 			hoedown_buffer_put(ref->title, data + title_offset, title_end - title_offset);
 		}
 	}
@@ -2801,6 +2854,7 @@ hoedown_document_new(
 
 	hoedown_stack_init(&doc->work_bufs[BUFFER_BLOCK], 4);
 	hoedown_stack_init(&doc->work_bufs[BUFFER_SPAN], 8);
+	doc->arena = NULL;
 
 	memset(doc->active_char, 0x0, 256);
 
@@ -2847,6 +2901,8 @@ hoedown_document_new(
 	if (extensions & HOEDOWN_EXT_MATH)
 		doc->active_char['$'] = MD_CHAR_MATH;
 
+	hoedown_charset_init(&doc->active_set, doc->active_char);
+
 	/* Extension data */
 	doc->ext_flags = extensions;
 	doc->max_nesting = max_nesting;
@@ -2855,6 +2911,19 @@ hoedown_document_new(
 	return doc;
 }
 
+hoedown_document *
+hoedown_document_new_arena(
+	const hoedown_renderer *renderer,
+	hoedown_extensions extensions,
+	size_t max_nesting,
+	size_t arena_size)
+{
+	hoedown_document *doc = hoedown_document_new(renderer, extensions, max_nesting);
+
+	doc->arena = hoedown_arena_new(arena_size);
+	return doc;
+}
+
 void
 hoedown_document_render(hoedown_document *doc, hoedown_buffer *ob, const uint8_t *data, size_t size)
 {
@@ -2865,7 +2934,7 @@ hoedown_document_render(hoedown_document *doc, hoedown_buffer *ob, const uint8_t
 
 	int footnotes_enabled;
 
-	text = hoedown_buffer_new(64);
+	text = doc_buffer_new(doc, 64);
 
 	/* Preallocate enough space for our buffer to avoid expanding while copying */
 	hoedown_buffer_grow(text, size);
@@ -2890,9 +2959,9 @@ hoedown_document_render(hoedown_document *doc, hoedown_buffer *ob, const uint8_t
 		beg += 3;
 
 	while (beg < size) /* iterating over lines */
-		if (footnotes_enabled && is_footnote(data, beg, size, &end, &doc->footnotes_found))
+		if (footnotes_enabled && is_footnote(doc, data, beg, size, &end, &doc->footnotes_found))
 			beg = end;
-		else if (is_ref(data, beg, size, &end, doc->refs))
+		else if (is_ref(doc, data, beg, size, &end, doc->refs))
 			beg = end;
 		else { /* skipping to the next line */
 			end = beg;
@@ -2937,21 +3006,22 @@ hoedown_document_render(hoedown_document *doc, hoedown_buffer *ob, const uint8_t
 
 	/* clean-up */
 	hoedown_buffer_free(text);
-	free_link_refs(doc->refs);
+	free_link_refs(doc, doc->refs);
 	if (footnotes_enabled) {
-		free_footnote_list(&doc->footnotes_found, 1);
-		free_footnote_list(&doc->footnotes_used, 0);
+		free_footnote_list(doc, &doc->footnotes_found, 1);
+		free_footnote_list(doc, &doc->footnotes_used, 0);
 	}
 
 	assert(doc->work_bufs[BUFFER_SPAN].size == 0);
 	assert(doc->work_bufs[BUFFER_BLOCK].size == 0);
+	release_arena(doc);
 }
 
 void
 hoedown_document_render_inline(hoedown_document *doc, hoedown_buffer *ob, const uint8_t *data, size_t size)
 {
 	size_t i = 0, mark;
-	hoedown_buffer *text = hoedown_buffer_new(64);
+	hoedown_buffer *text = doc_buffer_new(doc, 64);
 
 	/* reset the references table */
 	memset(&doc->refs, 0x0, REF_TABLE_SIZE * sizeof(void *));
@@ -2992,6 +3062,7 @@ hoedown_document_render_inline(hoedown_document *doc, hoedown_buffer *ob, const
 
 	assert(doc->work_bufs[BUFFER_SPAN].size == 0);
 	assert(doc->work_bufs[BUFFER_BLOCK].size == 0);
+	release_arena(doc);
 }
 
 void
@@ -3008,5 +3079,6 @@ hoedown_document_free(hoedown_document *doc)
 	hoedown_stack_uninit(&doc->work_bufs[BUFFER_SPAN]);
 	hoedown_stack_uninit(&doc->work_bufs[BUFFER_BLOCK]);
 
+	hoedown_arena_free(doc->arena);
 	free(doc);
 }
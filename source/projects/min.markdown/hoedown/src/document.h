@@ -155,6 +155,15 @@ hoedown_document *hoedown_document_new(
 	size_t max_nesting
 ) __attribute__ ((malloc));
 
+/* hoedown_document_new_arena: allocate a document processor that takes its working memory from an arena,
+ * released all at once at the end of every render; arena_size is the initial size of the arena */
+hoedown_document *hoedown_document_new_arena(
+	const hoedown_renderer *renderer,
+	hoedown_extensions extensions,
+	size_t max_nesting,
+	size_t arena_size
+) __attribute__ ((malloc));
+
 /* hoedown_document_render: render regular Markdown using the document processor */
 void hoedown_document_render(hoedown_document *doc, hoedown_buffer *ob, const uint8_t *data, size_t size);
 
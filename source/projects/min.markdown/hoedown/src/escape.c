@@ -1,5 +1,7 @@
 #include "escape.h"
 
+#include "scan.h"
+
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
@@ -146,6 +148,13 @@ static const uint8_t HTML_ESCAPE_TABLE[UINT8_MAX+1] = {
 	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 };
 
+/* the bytes in HTML_ESCAPE_TABLE, so that runs of bytes that need no escaping can be skipped together */
+static const hoedown_charset HTML_ESCAPE_SET = {
+	HTML_ESCAPE_TABLE,
+	{ '"', '&', '\'', '/', '<', '>' },
+	6
+};
+
 static const char *HTML_ESCAPES[] = {
         "",
         "&quot;",
@@ -163,7 +172,7 @@ hoedown_escape_html(hoedown_buffer *ob, const uint8_t *data, size_t size, int se
 
 	while (1) {
 		mark = i;
-		while (i < size && HTML_ESCAPE_TABLE[data[i]] == 0) i++;
+		i += hoedown_charset_find(&HTML_ESCAPE_SET, data + i, size - i);
 
 		/* Optimization for cases where there's nothing to escape */
 		if (mark == 0 && i >= size) {
@@ -0,0 +1,135 @@
+#include "scan.h"
+
+#include <assert.h>
+
+/*
+ * Blocks of 32 bytes are compared with AVX2 when the compiler targets it,
+ * and blocks of 16 bytes with SSE2 on any x86-64 or SSE2 x86 target.
+ * Each block is compared with every byte in the set and the first match
+ * is found from the mask of the comparisons. Anything left over, and
+ * every byte on other targets, is looked up in the table one at a time.
+ */
+
+#if defined(__AVX2__)
+#define HOEDOWN_SCAN_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HOEDOWN_SCAN_SSE2
+#endif
+
+#if defined(HOEDOWN_SCAN_AVX2)
+#include <immintrin.h>
+#elif defined(HOEDOWN_SCAN_SSE2)
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(HOEDOWN_SCAN_AVX2) || defined(HOEDOWN_SCAN_SSE2))
+#include <intrin.h>
+#endif
+
+void
+hoedown_charset_init(hoedown_charset *set, const uint8_t *table)
+{
+	size_t c;
+
+	assert(set && table);
+
+	set->table = table;
+	set->count = 0;
+
+	for (c = 0; c <= UINT8_MAX; ++c) {
+		if (!table[c])
+			continue;
+
+		if (set->count == HOEDOWN_CHARSET_MAX) {
+			set->count = 0;
+			return;
+		}
+		set->chars[set->count++] = (uint8_t)c;
+	}
+}
+
+/* bytes that are looked up one at a time before comparing blocks */
+#define SCAN_HEAD 16
+
+#if defined(HOEDOWN_SCAN_AVX2) || defined(HOEDOWN_SCAN_SSE2)
+
+/* index of the lowest set bit of a nonzero mask */
+static size_t
+first_bit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return (size_t)__builtin_ctz(mask);
+#endif
+}
+
+#endif
+
+size_t
+hoedown_charset_find(const hoedown_charset *set, const uint8_t *data, size_t size)
+{
+	size_t i = 0, head = size < SCAN_HEAD ? size : SCAN_HEAD;
+
+	assert(set);
+
+	/* the next byte of interest is often close by, where setting up the comparisons would cost more than they save */
+	for (; i < head; ++i)
+		if (set->table[data[i]])
+			return i;
+
+#if defined(HOEDOWN_SCAN_AVX2)
+	if (set->count && size - i >= 32) {
+		__m256i wanted[HOEDOWN_CHARSET_MAX];
+		size_t k;
+
+		for (k = 0; k < set->count; ++k)
+			wanted[k] = _mm256_set1_epi8((char)set->chars[k]);
+
+		for (; i + 32 <= size; i += 32) {
+			__m256i block = _mm256_loadu_si256((const __m256i *)(data + i));
+			__m256i found = _mm256_cmpeq_epi8(block, wanted[0]);
+			unsigned int mask;
+
+			for (k = 1; k < set->count; ++k)
+				found = _mm256_or_si256(found, _mm256_cmpeq_epi8(block, wanted[k]));
+
+			mask = (unsigned int)_mm256_movemask_epi8(found);
+			if (mask)
+				return i + first_bit(mask);
+		}
+	}
+#endif
+
+#if defined(HOEDOWN_SCAN_SSE2)
+	if (set->count && size - i >= 16) {
+		__m128i wanted[HOEDOWN_CHARSET_MAX];
+		size_t k;
+
+		for (k = 0; k < set->count; ++k)
+			wanted[k] = _mm_set1_epi8((char)set->chars[k]);
+
+		for (; i + 16 <= size; i += 16) {
+			__m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+			__m128i found = _mm_cmpeq_epi8(block, wanted[0]);
+			unsigned int mask;
+
+			for (k = 1; k < set->count; ++k)
+				found = _mm_or_si128(found, _mm_cmpeq_epi8(block, wanted[k]));
+
+			mask = (unsigned int)_mm_movemask_epi8(found);
+			if (mask)
+				return i + first_bit(mask);
+		}
+	}
+#endif
+
+	while (i < size && !set->table[data[i]])
+		i++;
+
+	return i;
+}
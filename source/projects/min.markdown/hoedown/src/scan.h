@@ -0,0 +1,50 @@
+/* scan.h - find the next byte of interest, many bytes at a time */
+
+#ifndef HOEDOWN_SCAN_H
+#define HOEDOWN_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*************
+ * CONSTANTS *
+ *************/
+
+/* the most bytes that a charset can compare against at once */
+#define HOEDOWN_CHARSET_MAX 16
+
+
+/*********
+ * TYPES *
+ *********/
+
+struct hoedown_charset {
+	const uint8_t *table;	/* 256 entries, nonzero for the bytes in the set */
+	uint8_t chars[HOEDOWN_CHARSET_MAX];	/* the bytes in the set */
+	size_t count;	/* number of bytes in chars, or 0 when there are too many to compare at once */
+};
+
+typedef struct hoedown_charset hoedown_charset;
+
+
+/*************
+ * FUNCTIONS *
+ *************/
+
+/* hoedown_charset_init: make a charset of the bytes with nonzero entries in a 256-entry table, which it refers to */
+void hoedown_charset_init(hoedown_charset *set, const uint8_t *table);
+
+/* hoedown_charset_find: the index of the first byte of data in the set, or size if there is none */
+size_t hoedown_charset_find(const hoedown_charset *set, const uint8_t *data, size_t size);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /** HOEDOWN_SCAN_H **/
@@ -0,0 +1,159 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2018 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#pragma once
+
+#include "block_splitter.h"
+#include "render_cache.h"
+#include "render_pool.h"
+#include <algorithm>
+#include <unordered_map>
+
+
+/// Renders the documents read by one object a run of blocks at a time,
+/// keeping the HTML of each run so that when an edited document is read again only the runs that changed are rendered.
+///
+/// Runs are found by their content, so a run that has moved because of an edit above it is still found.
+/// The HTML of a run is only reused where it renders the same as before: after the same number of headers if it has any,
+/// and with the same link references in the document.
+/// Documents that cannot be split (see block_splitter) are rendered whole.
+
+class incremental_renderer {
+public:
+	/// Render a document.
+	render_cache::html render(const char* markdown, size_t size) {
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		auto               context = render_pool::shared().acquire();
+		auto               outline = block_splitter::split(markdown, size, [&](const std::string& definitions) {
+			return references_usable(*context, definitions);
+		});
+		render_cache::html html;
+
+		if (outline.usable)
+			html = render_runs(*context, markdown, outline);
+		else {
+			m_fragments.clear();
+			html = context->render(markdown, size);
+		}
+
+		render_pool::shared().release(std::move(context));
+		return html;
+	}
+
+private:
+	struct fragment {
+		size_t      size { 0 };			///< of the Markdown, as a check on the hash
+		std::string html;
+		int         first_header { 0 };	///< the number of headers before the run when it was rendered
+		int         headers { 0 };
+		bool        following { false };	///< rendered after other HTML
+		uint64_t    generation { 0 };		///< the last document that used it
+	};
+
+	std::mutex                                          m_mutex;
+	std::unordered_map<uint64_t, std::vector<fragment>> m_fragments;	///< keyed on the hash of the run's Markdown, which may appear more than once
+	uint64_t                                            m_generation { 0 };
+	uint64_t                                            m_references_hash { 0 };
+	bool                                                m_references_usable { false };
+	std::string                                         m_source;		///< a run and the references it uses, as given to hoedown
+	std::unordered_set<std::string>                     m_ids;
+
+	// FNV-1a
+
+	static uint64_t hash(const char* data, size_t size) {
+		uint64_t h { 14695981039346656037ULL };
+
+		for (size_t i = 0; i < size; ++i) {
+			h ^= static_cast<uint8_t>(data[i]);
+			h *= 1099511628211ULL;
+		}
+		return h;
+	}
+
+	// The references a run uses are rendered ahead of it, so they must all be references hoedown accepts,
+	// in which case they render to nothing.
+	// Any change to them may change the HTML of any run.
+
+	bool references_usable(render_context& context, const std::string& definitions) {
+		auto h = hash(definitions.data(), definitions.size());
+
+		if (h != m_references_hash) {
+			std::string html;
+
+			context.render(definitions.data(), definitions.size(), 0, false, html);
+			m_fragments.clear();
+			m_references_hash   = h;
+			m_references_usable = html.empty();
+		}
+		return m_references_usable;
+	}
+
+	// the Markdown for a run: the run after the definitions of the references it may use
+
+	void prepare_source(const char* markdown, const char* data, size_t size, const block_splitter::outline& outline) {
+		m_source.clear();
+
+		if (!outline.references.empty() && std::memchr(data, '[', size)) {
+			m_ids.clear();
+
+			auto all = !block_splitter::link_ids(data, size, m_ids);
+
+			for (const auto& r : outline.references) {
+				if (all || m_ids.count(r.id) || r.id.find('[') != std::string::npos) {
+					m_source.append(markdown + r.definition.offset, r.definition.size);
+					if (m_source.back() != '\n')
+						m_source += '\n';
+					m_source += '\n';
+				}
+			}
+		}
+		m_source.append(data, size);
+	}
+
+	render_cache::html render_runs(render_context& context, const char* markdown, const block_splitter::outline& outline) {
+		std::string html;
+		int         headers {0};
+
+		++m_generation;
+
+		for (const auto& run : outline.runs) {
+			auto  data      = markdown + run.offset;
+			auto  following = !html.empty();
+			auto& versions  = m_fragments[hash(data, run.size)];
+			auto  f         = std::find_if(versions.begin(), versions.end(), [&](const fragment& v) {
+				return v.size == run.size && v.following == following && (v.headers == 0 || v.first_header == headers);
+			});
+
+			if (f == versions.end()) {
+				prepare_source(markdown, data, run.size, outline);
+				versions.emplace_back();
+				f               = versions.end() - 1;
+				f->size         = run.size;
+				f->first_header = headers;
+				f->following    = following;
+				f->headers      = context.render(m_source.data(), m_source.size(), headers, following, f->html);
+			}
+
+			f->generation = m_generation;
+			html += f->html;
+			headers += f->headers;
+		}
+
+		// forget the runs that are no longer in the document
+
+		for (auto i = m_fragments.begin(); i != m_fragments.end();) {
+			auto& versions = i->second;
+
+			versions.erase(std::remove_if(versions.begin(), versions.end(), [this](const fragment& v) { return v.generation != m_generation; }), versions.end());
+			if (versions.empty())
+				i = m_fragments.erase(i);
+			else
+				++i;
+		}
+
+		return std::make_shared<const std::string>(std::move(html));
+	}
+};
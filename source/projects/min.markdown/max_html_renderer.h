@@ -0,0 +1,247 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2018 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#pragma once
+
+#include "hoedown/src/buffer.h"
+#include "hoedown/src/document.h"
+#include "hoedown/src/escape.h"
+#include "hoedown/src/html.h"
+#include <cctype>
+#include <cstring>
+
+
+/// A hoedown HTML renderer that writes HTML ready for display in Max.
+///
+/// It is the standard hoedown HTML renderer with the callbacks that would write double quotes or paragraphs replaced:
+/// attributes are written in single quotes (so the HTML survives being passed as a Max symbol)
+/// and paragraphs are written as line breaks.
+/// Text is always escaped by hoedown so it never contains a double quote.
+/// Raw HTML in the document is copied with the same rewrites applied as it is written.
+///
+/// Only the extensions and flags used by min.markdown are covered:
+/// hard wraps, tables, footnotes, and the table of contents still write double quotes.
+
+namespace max_html {
+
+	#define MAX_HTML_PUTSL(output, literal) hoedown_buffer_put(output, reinterpret_cast<const uint8_t*>(literal), sizeof(literal) - 1)
+
+
+	// Copy raw HTML, rewriting double quotes and paragraph tags on the way.
+
+	inline void put_rewritten(hoedown_buffer* ob, const uint8_t* data, size_t size) {
+		auto end  = data + size;
+		auto copy = data;    // start of the run of bytes that are copied unchanged
+
+		for (auto p = data; p < end; ++p) {
+			if (*p == '"') {
+				hoedown_buffer_put(ob, copy, p - copy);
+				hoedown_buffer_putc(ob, '\'');
+				copy = p + 1;
+			}
+			else if (*p == '<' && end - p >= 3 && std::memcmp(p, "<p>", 3) == 0) {
+				hoedown_buffer_put(ob, copy, p - copy);
+				MAX_HTML_PUTSL(ob, "<br/>");
+				copy = p + 3;
+				p += 2;
+			}
+			else if (*p == '<' && end - p >= 4 && std::memcmp(p, "</p>", 4) == 0) {
+				hoedown_buffer_put(ob, copy, p - copy);
+				MAX_HTML_PUTSL(ob, "<br/>");
+				copy = p + 4;
+				p += 3;
+			}
+		}
+		hoedown_buffer_put(ob, copy, end - copy);
+	}
+
+
+	inline bool use_xhtml(const hoedown_renderer_data* data) {
+		auto state = static_cast<hoedown_html_renderer_state*>(data->opaque);
+		return (state->flags & HOEDOWN_HTML_USE_XHTML) != 0;
+	}
+
+
+	inline void blockcode(hoedown_buffer* ob, const hoedown_buffer* text, const hoedown_buffer* lang, const hoedown_renderer_data* data) {
+		if (ob->size)
+			hoedown_buffer_putc(ob, '\n');
+
+		if (lang) {
+			MAX_HTML_PUTSL(ob, "<pre><code class='language-");
+			hoedown_escape_html(ob, lang->data, lang->size, 0);
+			MAX_HTML_PUTSL(ob, "'>");
+		}
+		else
+			MAX_HTML_PUTSL(ob, "<pre><code>");
+
+		if (text)
+			hoedown_escape_html(ob, text->data, text->size, 0);
+
+		MAX_HTML_PUTSL(ob, "</code></pre>\n");
+	}
+
+
+	inline void blockhtml(hoedown_buffer* ob, const hoedown_buffer* text, const hoedown_renderer_data* data) {
+		if (!text)
+			return;
+
+		// trim the surrounding blank lines as the standard renderer does
+
+		size_t size = text->size;
+		while (size > 0 && text->data[size - 1] == '\n')
+			--size;
+
+		size_t start = 0;
+		while (start < size && text->data[start] == '\n')
+			++start;
+
+		if (start >= size)
+			return;
+
+		if (ob->size)
+			hoedown_buffer_putc(ob, '\n');
+
+		put_rewritten(ob, text->data + start, size - start);
+		hoedown_buffer_putc(ob, '\n');
+	}
+
+
+	inline void header(hoedown_buffer* ob, const hoedown_buffer* content, int level, const hoedown_renderer_data* data) {
+		auto state = static_cast<hoedown_html_renderer_state*>(data->opaque);
+
+		if (ob->size)
+			hoedown_buffer_putc(ob, '\n');
+
+		if (level <= state->toc_data.nesting_level)
+			hoedown_buffer_printf(ob, "<h%d id='toc_%d'>", level, state->toc_data.header_count++);
+		else
+			hoedown_buffer_printf(ob, "<h%d>", level);
+
+		if (content)
+			hoedown_buffer_put(ob, content->data, content->size);
+		hoedown_buffer_printf(ob, "</h%d>\n", level);
+	}
+
+
+	inline void paragraph(hoedown_buffer* ob, const hoedown_buffer* content, const hoedown_renderer_data* data) {
+		if (ob->size)
+			hoedown_buffer_putc(ob, '\n');
+
+		if (!content || !content->size)
+			return;
+
+		size_t i = 0;
+		while (i < content->size && std::isspace(content->data[i]))
+			++i;
+
+		if (i == content->size)
+			return;
+
+		MAX_HTML_PUTSL(ob, "<br/>");
+		hoedown_buffer_put(ob, content->data + i, content->size - i);
+		MAX_HTML_PUTSL(ob, "<br/>\n");
+	}
+
+
+	inline int autolink(hoedown_buffer* ob, const hoedown_buffer* link, hoedown_autolink_type type, const hoedown_renderer_data* data) {
+		if (!link || !link->size)
+			return 0;
+
+		MAX_HTML_PUTSL(ob, "<a href='");
+		if (type == HOEDOWN_AUTOLINK_EMAIL)
+			MAX_HTML_PUTSL(ob, "mailto:");
+		hoedown_escape_href(ob, link->data, link->size);
+		MAX_HTML_PUTSL(ob, "'>");
+
+		// don't show the mailto: prefix of an email address written as a URI
+
+		if (hoedown_buffer_prefix(link, "mailto:") == 0)
+			hoedown_escape_html(ob, link->data + 7, link->size - 7, 0);
+		else
+			hoedown_escape_html(ob, link->data, link->size, 0);
+
+		MAX_HTML_PUTSL(ob, "</a>");
+		return 1;
+	}
+
+
+	inline int image(hoedown_buffer* ob, const hoedown_buffer* link, const hoedown_buffer* title, const hoedown_buffer* alt, const hoedown_renderer_data* data) {
+		if (!link || !link->size)
+			return 0;
+
+		MAX_HTML_PUTSL(ob, "<img src='");
+		hoedown_escape_href(ob, link->data, link->size);
+		MAX_HTML_PUTSL(ob, "' alt='");
+
+		if (alt && alt->size)
+			hoedown_escape_html(ob, alt->data, alt->size, 0);
+
+		if (title && title->size) {
+			MAX_HTML_PUTSL(ob, "' title='");
+			hoedown_escape_html(ob, title->data, title->size, 0);
+		}
+
+		if (use_xhtml(data))
+			MAX_HTML_PUTSL(ob, "'/>");
+		else
+			MAX_HTML_PUTSL(ob, "'>");
+		return 1;
+	}
+
+
+	inline int link(hoedown_buffer* ob, const hoedown_buffer* content, const hoedown_buffer* link, const hoedown_buffer* title, const hoedown_renderer_data* data) {
+		MAX_HTML_PUTSL(ob, "<a href='");
+
+		if (link && link->size)
+			hoedown_escape_href(ob, link->data, link->size);
+
+		if (title && title->size) {
+			MAX_HTML_PUTSL(ob, "' title='");
+			hoedown_escape_html(ob, title->data, title->size, 0);
+		}
+
+		MAX_HTML_PUTSL(ob, "'>");
+
+		if (content && content->size)
+			hoedown_buffer_put(ob, content->data, content->size);
+		MAX_HTML_PUTSL(ob, "</a>");
+		return 1;
+	}
+
+
+	inline int raw_html(hoedown_buffer* ob, const hoedown_buffer* text, const hoedown_renderer_data* data) {
+		auto state = static_cast<hoedown_html_renderer_state*>(data->opaque);
+
+		// as with the standard renderer, ESCAPE overrides SKIP_HTML
+
+		if (state->flags & HOEDOWN_HTML_ESCAPE)
+			hoedown_escape_html(ob, text->data, text->size, 0);
+		else if (!(state->flags & HOEDOWN_HTML_SKIP_HTML))
+			put_rewritten(ob, text->data, text->size);
+		return 1;
+	}
+
+	#undef MAX_HTML_PUTSL
+
+
+	/// Create a renderer. Free it with hoedown_html_renderer_free().
+	/// @param	flags			The hoedown HTML flags, without HOEDOWN_HTML_HARD_WRAP.
+	/// @param	nesting_level	As for hoedown_html_renderer_new().
+	inline hoedown_renderer* renderer_new(hoedown_html_flags flags, int nesting_level) {
+		auto renderer = hoedown_html_renderer_new(flags, nesting_level);
+
+		renderer->blockcode = blockcode;
+		renderer->header    = header;
+		renderer->paragraph = paragraph;
+		renderer->autolink  = autolink;
+		renderer->image     = image;
+		renderer->link      = link;
+		renderer->raw_html  = raw_html;
+		if (renderer->blockhtml)    // the standard renderer leaves out HTML blocks when it skips or escapes HTML
+			renderer->blockhtml = blockhtml;
+		return renderer;
+	}
+
+}    // namespace max_html
@@ -4,66 +4,195 @@
 ///	@license	Use of this source code is governed by the MIT License found in the License.md file.
 
 #include "c74_min.h"
-#include "hoedown/src/document.h"
-#include "hoedown/src/html.h"
-#include <regex>
+#include "incremental_renderer.h"
+#include "render_cache.h"
+#include <condition_variable>
+#include <thread>
 
 using namespace c74::min;
 
 
 class markdown : public object<markdown> {
 public:
-    MIN_DESCRIPTION	{ "Get the approximate value of pi." };
-    MIN_TAGS		{ "math" };
+    MIN_DESCRIPTION	{ "Render a Markdown file as HTML." };
+    MIN_TAGS		{ "text" };
     MIN_AUTHOR		{ "Cycling '74" };
-    MIN_RELATED		{ "sin, cos, atan~, jit.op, gen~" };
+    MIN_RELATED		{ "jweb, textedit" };
 
-    inlet<>  input	{ this, "(bang) get the approximate value of pi" };
-    outlet<> output	{ this, "(number) approximate value of pi" };
+    inlet<>  input	{ this, "(read) Markdown file to render" };
+    outlet<> output	{ this, "(set) the rendered HTML" };
+
+    ~markdown() {
+        {
+            std::lock_guard<std::mutex> lock {m_mutex};
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        if (m_worker.joinable())
+            m_worker.join();
+    }
+
+    attribute<bool> m_async { this, "async", false,
+        description {"Render documents on a background thread so that reading a large file does not hold up Max. "
+                     "The HTML is output when the rendering is finished. "
+                     "Reading another file before then abandons the earlier rendering. "
+                     "Documents that have already been rendered are always output immediately."}
+    };
 
     message<> read { this, "read", "Markdown file to read",
         MIN_FUNCTION {
             try {
-                path              p {args};
-                std::ifstream     in {p};
-                std::string       s {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
-                hoedown_renderer* renderer {hoedown_html_renderer_new(static_cast<hoedown_html_flags>(0), 16)};
-                hoedown_buffer*   buffer {hoedown_buffer_new(100)};
+                path        p {args};
+                std::string filename = p;
+                auto        status   = file_status::of(filename);
+                auto        html     = render_cache::shared().find(filename, status);
+
+                if (html) {
+                    cancel();
+                    output_html(html);
+                }
+                else if (m_async)
+                    request(filename, status);
+                else {
+                    cancel();
+                    html = render(filename);
+                    render_cache::shared().store(filename, status, html);
+                    output_html(html);
+                }
+            }
+            catch (...) {
+                cerr << "Could not read file" << endl;
+            }
+
+            return {};
+        }
+    };
 
-                static const std::size_t nesting_depth = 16;
-                int                      extensions    = HOEDOWN_EXT_FENCED_CODE;
-                auto document = hoedown_document_new(renderer, static_cast<hoedown_extensions>(extensions), nesting_depth);
+private:
+    // a document to be rendered in the background
 
-                hoedown_document_render(document, buffer, reinterpret_cast<const uint8_t*>(&s[0]), s.size());
+    struct render_request {
+        std::string filename;
+        file_status status;
+        uint64_t    generation;
+    };
 
-                string     out {hoedown_buffer_cstr(buffer)};
-                std::regex rex {"\\\""};
-                string     out2 {std::regex_replace(out, rex, "'")};
-                std::regex rex2 {"src=\""};
-                string     out3 {std::regex_replace(out2, rex2, "src='")};
+    // guarded by m_mutex
 
-                std::regex rexp {"<p>"};
-                string     out4 {std::regex_replace(out3, rexp, "<br/>")};
-                std::regex rexp2 {"</p>"};
-                string     out5 {std::regex_replace(out4, rexp2, "<br/>")};
+    std::mutex              m_mutex;
+    std::condition_variable m_wake;
+    uint64_t                m_generation { 0 };        ///< the latest read; renderings for earlier reads are discarded
+    render_request          m_request;
+    bool                    m_requested { false };
+    render_cache::html      m_result;
+    bool                    m_failed { false };
+    uint64_t                m_result_generation { 0 };
+    bool                    m_stopping { false };
 
-                auto maxstring {c74::max::string_new(out5.c_str())};
-                atom a {maxstring};
+    std::thread             m_worker;                   ///< started by the first background rendering
 
-                output.send("set", a);
+    // output a rendering from the worker thread on the main thread
 
-                object_free(maxstring);
-                hoedown_buffer_free(buffer);
-                hoedown_html_renderer_free(renderer);
-            }
-            catch (...) {
-                cerr << "Could not read file" << endl;
+    queue<> m_deliver { this,
+        MIN_FUNCTION {
+            render_cache::html html;
+            bool               failed;
+
+            {
+                std::lock_guard<std::mutex> lock {m_mutex};
+
+                if (m_result_generation != m_generation)
+                    return {};
+                html   = std::move(m_result);
+                failed = m_failed;
+                m_result_generation = 0;
             }
 
+            if (failed)
+                cerr << "Could not read file" << endl;
+            else if (html)
+                output_html(html);
             return {};
         }
     };
 
+    void output_html(const render_cache::html& html) {
+        auto maxstring {c74::max::string_new(html->c_str())};
+        atom a {maxstring};
+
+        output.send("set", a);
+
+        object_free(maxstring);
+    }
+
+    // only the parts of a document that have changed since this object last rendered it are rendered again
+
+    incremental_renderer m_renderer;
+
+    render_cache::html render(const std::string& filename) {
+        mapped_file in {filename};
+        return m_renderer.render(in.data(), in.size());
+    }
+
+    // abandon any rendering in the background
+
+    void cancel() {
+        std::lock_guard<std::mutex> lock {m_mutex};
+
+        ++m_generation;
+        m_requested = false;
+    }
+
+    // ask the worker to render a document, replacing any request that it has not started
+
+    void request(const std::string& filename, const file_status& status) {
+        {
+            std::lock_guard<std::mutex> lock {m_mutex};
+
+            m_request   = {filename, status, ++m_generation};
+            m_requested = true;
+            if (!m_worker.joinable())
+                m_worker = std::thread {[this] { work(); }};
+        }
+        m_wake.notify_one();
+    }
+
+    // The worker thread.
+    // A rendering that is already inside hoedown cannot be interrupted, so a superseded rendering runs to completion
+    // and is then discarded (though it is still cached for the next time the file is read).
+
+    void work() {
+        std::unique_lock<std::mutex> lock {m_mutex};
+
+        while (true) {
+            m_wake.wait(lock, [this] { return m_requested || m_stopping; });
+            if (m_stopping)
+                return;
+
+            auto r      = std::move(m_request);
+            m_requested = false;
+            lock.unlock();
+
+            render_cache::html html;
+            bool               failed {false};
+
+            try {
+                html = render(r.filename);
+                render_cache::shared().store(r.filename, r.status, html);
+            }
+            catch (...) {
+                failed = true;
+            }
+
+            lock.lock();
+            if (r.generation == m_generation) {
+                m_result            = std::move(html);
+                m_failed            = failed;
+                m_result_generation = r.generation;
+                m_deliver.set();
+            }
+        }
+    }
 };
 
 MIN_EXTERNAL(markdown);
@@ -0,0 +1,85 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2018 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#pragma once
+
+#include "c74_min_api.h"
+#include "../shared/mapped_file.h"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+using namespace c74::min;
+
+
+/// A cache of rendered documents shared by every instance of the object.
+///
+/// Entries are keyed on the path of the file and are only valid for as long as the file's modification time and size
+/// are unchanged, so re-reading a file that has not been edited costs a single stat() of the file.
+/// The least recently used entries are dropped once the cache holds more than its capacity.
+
+class render_cache {
+public:
+	using html = std::shared_ptr<const std::string>;
+
+	/// The process-wide cache.
+	static render_cache& shared() {
+		static render_cache cache;
+		return cache;
+	}
+
+	/// Find a rendering of a file.
+	/// @param	filename	The path of the file.
+	/// @param	status		The current status of the file.
+	/// @return				The rendering or nullptr if there is no rendering of the file as it is now.
+	html find(const std::string& filename, const file_status& status) {
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		auto found = m_entries.find(filename);
+		if (found == m_entries.end())
+			return nullptr;
+		if (found->second->status != status) {
+			m_recent.erase(found->second);
+			m_entries.erase(found);
+			return nullptr;
+		}
+		m_recent.splice(m_recent.begin(), m_recent, found->second);
+		return found->second->rendering;
+	}
+
+	/// Remember a rendering of a file.
+	void store(const std::string& filename, const file_status& status, html rendering) {
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		auto found = m_entries.find(filename);
+		if (found != m_entries.end()) {
+			m_recent.erase(found->second);
+			m_entries.erase(found);
+		}
+		m_recent.push_front({filename, status, std::move(rendering)});
+		m_entries[filename] = m_recent.begin();
+
+		while (m_recent.size() > k_capacity) {
+			m_entries.erase(m_recent.back().filename);
+			m_recent.pop_back();
+		}
+	}
+
+private:
+	struct entry {
+		std::string filename;
+		file_status status;
+		html        rendering;
+	};
+
+	using entries = std::list<entry>;
+
+	static constexpr size_t k_capacity { 32 };    ///< documents that are kept
+
+	std::mutex                                         m_mutex;
+	entries                                            m_recent;    ///< most recently used first
+	std::unordered_map<std::string, entries::iterator> m_entries;
+};
@@ -0,0 +1,128 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2018 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#pragma once
+
+#include "max_html_renderer.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+/// Everything hoedown needs to render a document.
+/// Creating these is expensive relative to rendering a small document
+/// and their buffers grow to fit the documents they render, so they are reused through the render_pool.
+/// The document's working memory comes from an arena that is released in one go after each render.
+
+class render_context {
+public:
+	render_context()
+	: m_renderer {max_html::renderer_new(static_cast<hoedown_html_flags>(0), k_nesting_depth)}
+	, m_document {hoedown_document_new_arena(m_renderer, HOEDOWN_EXT_FENCED_CODE, k_nesting_depth, k_arena_size)}
+	, m_buffer {hoedown_buffer_new(k_buffer_unit)} {}
+
+	~render_context() {
+		hoedown_buffer_free(m_buffer);
+		hoedown_document_free(m_document);
+		hoedown_html_renderer_free(m_renderer);
+	}
+
+	render_context(const render_context&) = delete;
+	render_context& operator=(const render_context&) = delete;
+
+	/// Render Markdown to HTML.
+	std::shared_ptr<const std::string> render(const char* markdown, size_t size) {
+		std::string html;
+
+		render(markdown, size, 0, false, html);
+		return std::make_shared<const std::string>(std::move(html));
+	}
+
+	/// Render part of a document to HTML.
+	/// @param	markdown		The Markdown, which must start at the start of a block.
+	/// @param	size			The size of the Markdown.
+	/// @param	first_header	The number of headers earlier in the document, from which the header ids in this part count.
+	/// @param	following		True if HTML has already been written for earlier blocks,
+	///							so this part starts with the line break that separates blocks.
+	/// @param	html			Set to the HTML.
+	/// @return					The number of headers in this part.
+	int render(const char* markdown, size_t size, int first_header, bool following, std::string& html) {
+		// keep the memory of the output buffer for the next document unless it has grown unusually large
+
+		if (m_buffer->asize > k_max_kept)
+			hoedown_buffer_reset(m_buffer);
+		m_buffer->size = 0;
+
+		// hoedown only separates a block from the ones before it when there is output already,
+		// so a placeholder byte stands in for the earlier blocks
+
+		if (following)
+			hoedown_buffer_putc(m_buffer, ' ');
+
+		// headers are numbered from zero in every document but the html renderer only resets its count for a table of contents
+
+		auto state = static_cast<hoedown_html_renderer_state*>(m_renderer->opaque);
+		state->toc_data.header_count = first_header;
+
+		hoedown_document_render(m_document, m_buffer, reinterpret_cast<const uint8_t*>(markdown), size);
+
+		auto skip = following ? 1 : 0;
+		html.assign(reinterpret_cast<const char*>(m_buffer->data) + skip, m_buffer->size - skip);
+		return state->toc_data.header_count - first_header;
+	}
+
+private:
+	static constexpr int    k_nesting_depth	{ 16 };
+	static constexpr size_t k_buffer_unit	{ 1024 };
+	static constexpr size_t k_arena_size	{ 64 * 1024 };    ///< initial bytes of working memory, grown to fit the largest document
+	static constexpr size_t k_max_kept		{ 4 * 1024 * 1024 };    ///< bytes of output buffer kept between renders
+
+	hoedown_renderer* m_renderer;
+	hoedown_document* m_document;
+	hoedown_buffer*   m_buffer;
+};
+
+
+/// Idle render contexts shared by every instance of the object, on every thread.
+
+class render_pool {
+public:
+	using context = std::unique_ptr<render_context>;
+
+	/// The process-wide pool.
+	static render_pool& shared() {
+		static render_pool pool;
+		return pool;
+	}
+
+	/// Take an idle context, or create one if there are none.
+	context acquire() {
+		{
+			std::lock_guard<std::mutex> lock {m_mutex};
+
+			if (!m_idle.empty()) {
+				auto c = std::move(m_idle.back());
+				m_idle.pop_back();
+				return c;
+			}
+		}
+		return context {new render_context};
+	}
+
+	/// Return a context for reuse.
+	void release(context c) {
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		if (m_idle.size() < k_max_idle)
+			m_idle.push_back(std::move(c));
+	}
+
+private:
+	static constexpr size_t k_max_idle { 4 };
+
+	std::mutex           m_mutex;
+	std::vector<context> m_idle;
+};
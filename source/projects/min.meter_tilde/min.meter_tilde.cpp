@@ -4,16 +4,17 @@
 ///	@license	Use of this source code is governed by the MIT License found in the License.md file.
 
 #include "c74_min.h"
+#include "../shared/level_detector.h"
 
 using namespace c74::min;
 using namespace c74::min::ui;
 
-class min_meter : public object<min_meter>, public ui_operator<140, 24>, public sample_operator<1, 0> {
+class min_meter : public object<min_meter>, public ui_operator<140, 24>, public vector_operator<> {
 public:
     MIN_DESCRIPTION	{ "Show audio gain levels" };
     MIN_TAGS		{ "ui" };
     MIN_AUTHOR		{ "Cycling '74" };
-    MIN_RELATED		{ "meter~, live.meter~" };
+    MIN_RELATED		{ "meter~, live.meter~, mc.min.meter~" };
 
     inlet<>  input	{ this, "(signal) audio to measure / visualize" };
     outlet<> output	{ this, "(number) value" };
@@ -32,11 +33,36 @@ public:
 	attribute<color>   m_elementcolor {this, "elementcolor", color::predefined::white};
 	attribute<color>   m_knobcolor {this, "knobcolor", color::predefined::gray, title {"Knob Color"}};
 
+    enum class modes : int { peak, rms, enum_count };
+
+    enum_map mode_range = {"peak", "rms"};
+
+    attribute<modes> m_mode { this, "mode", modes::peak, mode_range,
+        description {"Level that is displayed and output: the peak amplitude or the RMS (average power)."}
+    };
+
+    attribute<number, threadsafe::yes, limit::clamp> m_attack { this, "attack", 0.0,
+        range {0.0, 10000.0},
+        description {"Time in ms for the meter to rise to a louder level."}
+    };
+
+    attribute<number, threadsafe::yes, limit::clamp> m_release { this, "release", 300.0,
+        range {0.0, 10000.0},
+        description {"Time in ms for the meter to fall to a quieter level."}
+    };
+
+    attribute<number, threadsafe::yes, limit::clamp> m_hold { this, "hold", 1000.0,
+        range {0.0, 60000.0},
+        description {"Time in ms that the highest recent peak is held before it falls back to the meter. Zero hides the peak marker."}
+    };
+
     message<> paint { this, "paint",
         MIN_FUNCTION {
             target t {args};
-            auto   value = (m_value - m_range[0]) / (m_range[1] - m_range[0]);
-            auto   pos   = ((t.width() - 3) * value) + 1;    // one pixel for each border and -1 for counting to N-1
+            auto   pos  = pixel_for(m_value, t.width());
+            auto   held = pixel_for(m_held_value, t.width());
+
+            m_width = t.width();
 
             rect<fill> {// background
                 t,
@@ -59,6 +85,14 @@ public:
                 position {pos, 1.0},
                 size {4.0, -2.0}
             };
+            if (m_hold > 0.0) {
+                rect<fill> {// peak hold marker
+                    t,
+                    color {m_elementcolor},
+                    position {held, 1.0},
+                    size {2.0, -2.0}
+                };
+            }
             text {// text display
                 t, color {color::predefined::white},
                 position {m_offset[0], m_offset[1] + m_fontsize * 0.5},
@@ -66,27 +100,59 @@ public:
                 fontsize {m_fontsize},
                 content {static_cast<symbol&>(m_label)}
             };
+
+            m_drawn_position      = pos;
+            m_drawn_held_position = held;
             return {};
         }
     };
 
+    // The meter is only redrawn, and the level only output, when the display would move by at least one pixel.
+    // A silent or steady meter costs nothing but this check.
+
     timer<timer_options::defer_delivery> m_timer { this,
         MIN_FUNCTION {
-            m_value = MIN_CLAMP(m_unclipped_value, m_range[0], m_range[1]);
-            redraw();
-            output.send(m_unclipped_value);
+            auto level = (m_mode == modes::rms) ? m_detector.rms() : m_detector.peak();
+
+            m_held_for += 40.0;
+            if (level >= m_held_value || m_held_for >= m_hold) {
+                m_held_value = level;
+                m_held_for   = 0.0;
+            }
+
+            m_value = MIN_CLAMP(level, m_range[0], m_range[1]);
+
+            auto moved = std::abs(pixel_for(m_value, m_width) - m_drawn_position) >= 1.0
+                      || std::abs(pixel_for(m_held_value, m_width) - m_drawn_held_position) >= 1.0;
+
+            if (moved) {
+                redraw();
+                output.send(level);
+            }
             m_timer.delay(40);
             return {};
         }
     };
 
-    void operator()(sample input) {
-        m_unclipped_value = input;
+    void operator()(audio_bundle input, audio_bundle output) {
+        m_detector(input.samples(0), input.frame_count(), samplerate(), m_attack, m_release);
     }
 
 private:
-    number m_unclipped_value {0.0};
-    number m_value;
+    level_detector m_detector;
+    number         m_value {0.0};
+    number         m_held_value {0.0};
+    number         m_held_for {0.0};                 ///< ms since the held peak was last raised
+    number         m_width {140.0};                  ///< width of the meter when it was last painted
+    number         m_drawn_position {-1.0};          ///< pixel positions when the meter was last painted
+    number         m_drawn_held_position {-1.0};
+
+    // the pixel at which to draw a value: one pixel for each border and -1 for counting to N-1
+
+    number pixel_for(number value, number width) {
+        auto normalized = (MIN_CLAMP(value, m_range[0], m_range[1]) - m_range[0]) / (m_range[1] - m_range[0]);
+        return ((width - 3) * normalized) + 1;
+    }
 };
 
 MIN_EXTERNAL(min_meter);
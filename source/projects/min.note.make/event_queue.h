@@ -0,0 +1,107 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2018 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/// A bounded lock-free queue that may be written from any number of threads and read from any number of threads.
+///
+/// The fifo<> provided by Min is faster but it only supports a single producer and a single consumer.
+/// This queue is for when events can arrive from several threads at once (e.g. both the main thread and the scheduler).
+/// It is based on the bounded MPMC queue described by Dmitry Vyukov: each cell carries a sequence number
+/// which tells producers and consumers whether the cell is ready for them, so a push or pop is a single compare-and-swap.
+///
+/// @tparam	T	The type of the items in the queue. It must be default-constructible and copyable.
+
+template<class T>
+class event_queue {
+public:
+	/// Create a queue.
+	/// @param	capacity	The maximum number of items in the queue. It is rounded up to a power of two.
+	explicit event_queue(std::size_t capacity) {
+		std::size_t size = 2;
+		while (size < capacity)
+			size <<= 1;
+
+		m_cells = std::vector<cell>(size);
+		m_mask  = size - 1;
+		for (std::size_t i = 0; i < size; ++i)
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	event_queue(const event_queue&) = delete;
+	event_queue& operator=(const event_queue&) = delete;
+
+	/// Add an item to the queue.
+	/// @return	False if the queue was full and the item was not added.
+	bool try_enqueue(const T& item) {
+		auto  position = m_enqueue_position.load(std::memory_order_relaxed);
+		cell* c;
+
+		for (;;) {
+			c = &m_cells[position & m_mask];
+
+			auto sequence   = c->sequence.load(std::memory_order_acquire);
+			auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+			if (difference == 0) {
+				if (m_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (difference < 0)
+				return false;
+			else
+				position = m_enqueue_position.load(std::memory_order_relaxed);
+		}
+		c->item = item;
+		c->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// Remove the oldest item from the queue.
+	/// @return	False if the queue was empty.
+	bool try_dequeue(T& item) {
+		auto  position = m_dequeue_position.load(std::memory_order_relaxed);
+		cell* c;
+
+		for (;;) {
+			c = &m_cells[position & m_mask];
+
+			auto sequence   = c->sequence.load(std::memory_order_acquire);
+			auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+
+			if (difference == 0) {
+				if (m_dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (difference < 0)
+				return false;
+			else
+				position = m_dequeue_position.load(std::memory_order_relaxed);
+		}
+		item = c->item;
+		c->sequence.store(position + m_mask + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	struct cell {
+		std::atomic<std::size_t> sequence;
+		T                   item;
+	};
+
+	std::vector<cell> m_cells;
+	std::size_t            m_mask;
+
+	// the positions are written by different threads so we keep them on separate cache lines
+
+	alignas(64) std::atomic<std::size_t> m_enqueue_position {0};
+	alignas(64) std::atomic<std::size_t> m_dequeue_position {0};
+};
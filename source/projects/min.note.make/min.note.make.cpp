@@ -4,7 +4,9 @@
 ///	@license	Use of this source code is governed by the MIT License found in the License.md file.
 
 #include "c74_min.h"
-#include <queue>
+#include "event_queue.h"
+#include <algorithm>
+#include <cstdint>
 
 using namespace c74::min;
 
@@ -14,49 +16,50 @@ using velocity = int;
 using duration = int;
 
 
-// forward declaration of the note class so we can use it in the definition of `note`
+// A note-on that is waiting for its note-off.
 
-class note_make;
+struct note {
+    double        m_off_time;    // when the note-off is due, in ms on the system timer
+    pitch         m_pitch;       // pitch we keep for the noteoff
+    velocity      m_velocity;    // velocity we keep for choosing the quietest note to steal
+    std::uint64_t m_order;       // order in which the notes started, for choosing the oldest note to steal
 
+    // std::push_heap() and friends build a max-heap so we reverse the comparison to keep the earliest note-off on top
 
-// the note class represents a single note generated by the note_make class
-// here we just create the class interface...
-// the implementation will be later so that we have access to e.g. the outlets of note_make
-
-class note {
-public:
-    note(note_make* owner, pitch, duration);
-
-    long id() {
-        return m_id;
+    bool operator<(const note& other) const {
+        return m_off_time > other.m_off_time;
     }
-
-private:
-    note_make*         m_owner;     // we need to know who our owner is for the timer setup and the outlet calls
-    pitch              m_pitch;     // pitch we keep for the noteoff, we don't need velocity
-    c74::min::function m_off_fn;    // note-off function callback for the timer
-    timer<>            m_timer;     // each note has its own timer to trigger the noteoff
-    long               m_id;        // unique serial number for each note
-
-    static long s_counter;
 };
 
 
-// We maintain our collection of active notes in a list.
+// We maintain our collection of active notes in a min-heap ordered by the time of their note-off.
 // We cannot use a FIFO queue because the duration of the notes may all be independent.
 //
-// Instead of keeping copies of the notes we use references, actually we use unique_ptr...
-// We do this (avoid copies) because the note contains a timer and we cannot make copies of timers.
+// All note-offs are driven by a single timer which is always set for the note at the top of the heap.
+// Adding a note or expiring one is O(log n) and, because the storage is reserved up-front,
+// no memory is allocated for each note.
+//
+// The number of notes is capped by the polyphony attribute, which can never exceed the reserved storage.
+// When a new note arrives and no voice is free, one of the sounding notes is stolen (ended early) to make room.
+// Finding and removing the note to steal is a scan of the bounded storage, so each note-on does a bounded amount of work.
 
-using notes = std::list<std::unique_ptr<note>>;
+using notes = std::vector<note>;
+
+
+// A complete note event as received by the list message.
+// Carrying all three values together means they can never be mismatched by another thread.
+
+struct note_event {
+    pitch    m_pitch;
+    velocity m_velocity;
+    duration m_duration;
+};
 
 
 // Finally, our Max class ...
 
 class note_make : public object<note_make> {
 public:
-    friend class note;
-
     MIN_DESCRIPTION	{ "Generate a note-on/note-off pair. Just like the makenote object." };
     MIN_TAGS		{ "midi, time" };
     MIN_AUTHOR		{ "Cycling '74" };
@@ -81,17 +84,37 @@ public:
         }
     };
 
+    note_make(const atoms& args = {}) {
+        m_notes.reserve(k_max_voices);
+    }
+
+    attribute<int, threadsafe::yes, limit::clamp> polyphony { this, "polyphony", k_max_voices,
+        range {1, k_max_voices},
+        description {"Maximum number of notes that may sound at once."}
+    };
+
+    enum class steal_policy : int { oldest, quietest, retrigger, enum_count };
+
+    enum_map steal_policy_range = {"oldest", "quietest", "retrigger"};
+
+    attribute<steal_policy> steal { this, "steal", steal_policy::oldest, steal_policy_range,
+        description {"Note that is ended early when a new note arrives and there are no free voices. "
+                     "'retrigger' ends a note of the same pitch whether or not there is a free voice, "
+                     "otherwise it steals the oldest note."}
+    };
+
     // the truth is that this only sort-of threadsafe
     // when receiving some bits of info from the scheduler and some from the main thread
     // it won't crash or do anything catastrophic
     // however, the wrong velocities might be paired with the wrong pitches, etc.
+    // senders on more than one thread should use the list message instead.
 
     message<threadsafe::yes> m_ints {
         this, "int", "MIDI note information", MIN_FUNCTION {
             switch (inlet) {
                 case 0:
                     m_pitch = args[0];
-                    start();
+                    start(m_pitch, m_velocity, m_duration);
                     break;
                 case 1:
                     m_velocity = args[0];
@@ -106,53 +129,168 @@ public:
         }
     };
 
-private:
-    notes    m_notes;
-    pitch    m_pitch;
-    velocity m_velocity;
-    duration m_duration;
+    // A list of pitch, velocity, and duration is received as a single event.
+    // Events from any thread are pushed onto a lock-free queue and played on the scheduler thread,
+    // which keeps the output ordered and timed by the scheduler no matter where the events came from.
+
+    message<threadsafe::yes> list {
+        this, "list", "A complete note as a list of pitch, velocity, and duration.", MIN_FUNCTION {
+            if (args.size() != 3) {
+                cerr << "expected a list of pitch, velocity, and duration" << endl;
+                return {};
+            }
+
+            note_event event {args[0], args[1], args[2]};
 
-    void start() {
-        velocity_out.send(m_velocity);
-        pitch_out.send(m_pitch);
-        m_notes.push_back(std::make_unique<note>(this, m_pitch, m_duration));
+            if (c74::max::systhread_istimerthread()) {
+                play_events();
+                start(event.m_pitch, event.m_velocity, event.m_duration);
+            }
+            else if (m_events.try_enqueue(event))
+                m_event_timer.delay(0);
+            else
+                cwarn << "note queue is full, event dropped" << endl;
+            return {};
+        }
+    };
+
+    // plays the events queued by the list message
+
+    timer<> m_event_timer { this,
+        MIN_FUNCTION {
+            play_events();
+            return {};
+        }
+    };
+
+    // a single timer sends the note-offs for all of the notes
+
+    timer<> m_off_timer { this,
+        MIN_FUNCTION {
+            pitch expired[k_batch_size];
+            bool  more {true};
+
+            // we collect the due note-offs while holding the lock but send them after releasing it
+            // so that objects downstream can send new notes back to us without deadlocking
+
+            while (more) {
+                size_t count {};
+                lock   lock {m_mutex};
+                auto   now = c74::max::systimer_gettime();
+
+                while (!m_notes.empty() && m_notes.front().m_off_time <= now && count < k_batch_size) {
+                    expired[count++] = m_notes.front().m_pitch;
+                    std::pop_heap(m_notes.begin(), m_notes.end());
+                    m_notes.pop_back();
+                }
+                more = (count == k_batch_size);
+                if (!more && !m_notes.empty())
+                    m_off_timer.delay(m_notes.front().m_off_time - now);
+                lock.unlock();
+
+                for (size_t i = 0; i < count; ++i) {
+                    velocity_out.send(0);
+                    pitch_out.send(expired[i]);
+                }
+            }
+            return {};
+        }
+    };
+
+private:
+    notes                   m_notes;
+    mutex                   m_mutex;
+    event_queue<note_event> m_events { k_queued_events };
+    pitch                   m_pitch;
+    velocity                m_velocity;
+    duration                m_duration;
+    std::uint64_t           m_order {};
+
+    static constexpr int    k_max_voices		{ 256 };    ///< storage reserved for the notes and the upper limit of the polyphony
+    static constexpr size_t k_batch_size		{ 64 };     ///< note-offs sent for each acquisition of the lock
+    static constexpr size_t k_queued_events		{ 1024 };   ///< list events that can be waiting for the scheduler
+
+    void play_events() {
+        note_event event;
+
+        while (m_events.try_dequeue(event))
+            start(event.m_pitch, event.m_velocity, event.m_duration);
     }
 
-    void remove(long note_id) {
-        bool note_removed = false;
+    // Choose the note to steal when there are no free voices.
+    // The 'retrigger' policy has already had its chance to end a note of the same pitch, so here it behaves like 'oldest'.
+
+    size_t choose_victim() {
+        auto quietest = (steal.get() == steal_policy::quietest);
+        auto victim   = size_t {0};
 
-        for (auto iter = m_notes.begin(); iter != m_notes.end(); ++iter) {
-            const auto& stored_note = (*iter).get();
+        for (auto i = size_t {1}; i < m_notes.size(); ++i) {
+            const auto& candidate = m_notes[i];
+            const auto& chosen    = m_notes[victim];
 
-            if (stored_note->id() == note_id) {
-                m_notes.erase(iter);
-                note_removed = true;
-                break;
+            if (quietest && candidate.m_velocity != chosen.m_velocity) {
+                if (candidate.m_velocity < chosen.m_velocity)
+                    victim = i;
             }
+            else if (candidate.m_order < chosen.m_order)
+                victim = i;
         }
-        assert(note_removed);    // post-condition: if a note wasn't removed we have serious problems.
+        return victim;
+    }
+
+    // Remove a note from the middle of the heap.
+    // If it was the next note to end then the timer will fire early, find nothing due, and re-arm itself.
+
+    void remove_note(size_t index) {
+        m_notes[index] = m_notes.back();
+        m_notes.pop_back();
+        std::make_heap(m_notes.begin(), m_notes.end());
     }
-};
 
+    void start(pitch a_pitch, velocity a_velocity, duration a_duration) {
+        pitch  stolen[k_max_voices];
+        size_t stolen_count {};
+        auto   voices = static_cast<size_t>(polyphony.get());
 
-// The implementation of the constructor for the note class ...
-// The order of initialization is critical
-
-note::note(note_make* owner, pitch a_pitch, duration a_duration)
-: m_owner {owner}
-, m_pitch {a_pitch}
-, m_off_fn { MIN_FUNCTION {
-    m_owner->velocity_out.send(0);
-    m_owner->pitch_out.send(m_pitch);
-    m_owner->remove(m_id);
-    return {};
-}}
-, m_timer {m_owner, m_off_fn}
-, m_id {++s_counter} {
-    m_timer.delay(a_duration);
-}
-
-long note::s_counter = 0;
+        lock lock {m_mutex};
+
+        if (steal.get() == steal_policy::retrigger) {
+            auto same = std::find_if(m_notes.begin(), m_notes.end(), [a_pitch](const note& n) { return n.m_pitch == a_pitch; });
+
+            if (same != m_notes.end()) {
+                stolen[stolen_count++] = a_pitch;
+                remove_note(same - m_notes.begin());
+            }
+        }
+
+        // the polyphony may have just been reduced so we might need to steal more than one note
+
+        while (m_notes.size() >= voices) {
+            auto victim = choose_victim();
+
+            stolen[stolen_count++] = m_notes[victim].m_pitch;
+            remove_note(victim);
+        }
+
+        auto off_time = c74::max::systimer_gettime() + a_duration;
+
+        m_notes.push_back({off_time, a_pitch, a_velocity, m_order++});
+        std::push_heap(m_notes.begin(), m_notes.end());
+
+        // only re-arm the timer if this note is now the next one to end
+
+        if (m_notes.front().m_off_time == off_time)
+            m_off_timer.delay(a_duration);
+        lock.unlock();
+
+        for (size_t i = 0; i < stolen_count; ++i) {
+            velocity_out.send(0);
+            pitch_out.send(stolen[i]);
+        }
+        velocity_out.send(a_velocity);
+        pitch_out.send(a_pitch);
+    }
+};
 
 
 MIN_EXTERNAL(note_make);
@@ -5,6 +5,8 @@
 
 #include "c74_min_unittest.h"    // required unit test header
 #include "min.note.make.cpp"     // need the source of our object so that we can access it
+#include <atomic>
+#include <thread>
 
 // Unit tests are written using the Catch framework as described at
 // https://github.com/philsquared/Catch/blob/master/docs/tutorial.md
@@ -16,7 +18,104 @@ SCENARIO("object produces correct output") {
 
         test_wrapper<note_make> an_instance;
         note_make&              my_object = an_instance;
-        
-        UNUSED(my_object);
+
+        WHEN("more notes are played than the polyphony allows") {
+            my_object.polyphony = 2;
+            my_object.m_ints({100}, 1);
+            my_object.m_ints({1000}, 2);
+            my_object.m_ints({60}, 0);
+            my_object.m_ints({62}, 0);
+            my_object.m_ints({64}, 0);
+
+            THEN("the oldest note is ended before the new one starts") {
+                auto& pitches    = *c74::max::object_getoutput(my_object, 0);
+                auto& velocities = *c74::max::object_getoutput(my_object, 1);
+
+                REQUIRE((pitches.size() == 4));
+                REQUIRE((pitches[2][0] == 60));
+                REQUIRE((velocities[2][0] == 0));
+                REQUIRE((pitches[3][0] == 64));
+                REQUIRE((velocities[3][0] == 100));
+            }
+        }
+    }
+}
+
+
+SCENARIO("note events may be queued from several threads at once") {
+
+    GIVEN("A queue with room for 8 events") {
+        event_queue<note_event> queue {8};
+
+        WHEN("more events are added than it can hold") {
+            auto added = 0;
+            for (auto i = 0; i < 10; ++i)
+                added += queue.try_enqueue({60 + i, 100, 250});
+
+            THEN("the extra events are refused and the others come out in order") {
+                REQUIRE(added == 8);
+
+                note_event event;
+                for (auto i = 0; i < 8; ++i) {
+                    REQUIRE(queue.try_dequeue(event));
+                    REQUIRE(event.m_pitch == 60 + i);
+                    REQUIRE(event.m_velocity == 100);
+                    REQUIRE(event.m_duration == 250);
+                }
+                REQUIRE(!queue.try_dequeue(event));
+            }
+        }
+    }
+
+    GIVEN("Four threads adding events to a queue") {
+        event_queue<note_event>  queue {64};
+        std::vector<std::thread> producers;
+        std::atomic<int>         finished {0};
+        constexpr auto           count = 10000;
+
+        for (auto t = 0; t < 4; ++t) {
+            producers.emplace_back([&queue, &finished, t] {
+                for (auto i = 0; i < count; ++i) {
+                    while (!queue.try_enqueue({t, i, 0}))
+                        std::this_thread::yield();
+                }
+                ++finished;
+            });
+        }
+
+        // collect everything before checking anything, since a failed check must not leave the producers running
+
+        std::vector<note_event> received;
+        note_event              event;
+
+        received.reserve(4 * count);
+        for (;;) {
+            auto done = (finished == 4);
+
+            if (queue.try_dequeue(event))
+                received.push_back(event);
+            else if (done)
+                break;
+        }
+        for (auto& producer : producers)
+            producer.join();
+
+        THEN("every event arrives intact and each thread's events arrive in order") {
+            int  next[4] {};
+            auto in_order = true;
+
+            for (const auto& e : received) {
+                if (e.m_pitch < 0 || e.m_pitch >= 4 || e.m_velocity != next[e.m_pitch]) {
+                    in_order = false;
+                    break;
+                }
+                ++next[e.m_pitch];
+            }
+
+            REQUIRE(in_order);
+            REQUIRE(received.size() == static_cast<size_t>(4 * count));
+            for (auto n : next)
+                REQUIRE(n == count);
+        }
     }
 }
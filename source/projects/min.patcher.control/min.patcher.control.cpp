@@ -4,6 +4,7 @@
 ///	@license	Use of this source code is governed by the MIT License found in the License.md file.
 
 #include "c74_min.h"
+#include "patcher_model.h"
 
 using namespace c74::min;
 
@@ -21,44 +22,56 @@ public:
 
     message<> m_box_count { this, "box_count", "Return the total number of boxes in this patcher.",
         MIN_FUNCTION {
-            auto p = patcher();
-            auto boxes = p.boxes();
-            
-            m_out.send(boxes.size());
+            m_model.update(maxobj());
+            m_out.send(m_model.size());
             return {};
         }
     };
     
     message<> m_classnames { this, "classnames", "Return the classnames of all boxes in this patcher.",
         MIN_FUNCTION {
-            auto p = patcher();
-            auto boxes = p.boxes();
-            atoms as {};
-            
-            for (const auto& b : boxes)
-                as.push_back(b.classname());
-            m_out.send(as);
+            m_model.update(maxobj());
+            m_out.send(m_model.classnames());
             return {};
         }
     };
    
     message<> m_boxpaths { this, "boxpaths", "Return the paths of all boxes in this patcher.",
         MIN_FUNCTION {
-            auto p = patcher();
-            auto boxes = p.boxes();
-            atoms as {};
-            
-            for (const auto& b : boxes)
-                as.push_back(b.path());
-            m_out.send(as);
+            m_model.update(maxobj());
+            m_out.send(m_model.paths());
             return {};
         }
     };
 
+    message<> m_changes { this, "changes",
+        "Return the paths of the boxes added to this patcher since the last changes query, preceded by 'added', "
+        "and then the paths of the boxes removed, preceded by 'removed'. "
+        "The first query returns every box as added.",
+        MIN_FUNCTION {
+            atoms added {symbol("added")};
+            atoms removed {symbol("removed")};
+
+            m_model.update(maxobj());
+            m_model.take_changes(added, removed);
+            m_out.send(added);
+            m_out.send(removed);
+            return {};
+        }
+    };
+
+    message<> m_notify { this, "notify",
+        MIN_FUNCTION {
+            notification n { args };
+
+            m_model.notify(n.source(), n.name());
+            return {};
+        }
+    };
 
     
 private:
-    
+    patcher_model m_model;    ///< the boxes of the patcher as of the last query
 };
 
 MIN_EXTERNAL(patcher_control);
@@ -0,0 +1,204 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2020 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#pragma once
+
+#include "c74_min_api.h"
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+
+/// What an object's patcher contains, kept between queries so that a query does not have to gather it again.
+///
+/// Each query checks the patcher's list of boxes against the boxes it knows, which only compares pointers,
+/// and looks up the class name and path of a box only when the box is new or has told us that it changed.
+/// The owner is attached to every box and must pass the notifications it receives on to notify().
+/// The lists of class names and paths are only built again after the boxes have changed.
+
+class patcher_model {
+public:
+	patcher_model() = default;
+
+	~patcher_model() {
+		for (const auto& b : m_boxes)
+			c74::max::object_detach_byptr(m_owner, b.first);
+	}
+
+	patcher_model(const patcher_model&) = delete;
+	patcher_model& operator=(const patcher_model&) = delete;
+
+
+	/// Bring the model up to date with the patcher.
+	/// @param	owner	The object whose patcher is modelled.
+	void update(c74::max::t_object* owner) {
+		using namespace c74::max;
+
+		t_object* patcher {nullptr};
+
+		m_owner = owner;
+		object_obex_lookup(owner, gensym("#P"), &patcher);
+
+		// the usual case: the same boxes in the same order
+
+		auto   same = !m_stale;
+		size_t count {0};
+
+		for (auto b = patcher ? jpatcher_get_firstobject(patcher) : nullptr; b; b = jbox_get_nextobject(b), ++count) {
+			if (same && (count >= m_order.size() || m_order[count] != b))
+				same = false;
+		}
+		if (same && count == m_order.size())
+			return;
+
+		// otherwise find the boxes that have come and gone, and refresh the ones that have changed
+
+		auto different = false;
+
+		++m_pass;
+		m_previous.swap(m_order);
+		m_order.clear();
+		for (auto b = patcher ? jpatcher_get_firstobject(patcher) : nullptr; b; b = jbox_get_nextobject(b)) {
+			auto known = m_boxes.find(b);
+
+			if (known == m_boxes.end()) {
+				known = m_boxes.emplace(b, describe(b)).first;
+				object_attach_byptr_register(m_owner, b, gensym("box"));
+				added(b, known->second.path);
+				different = true;
+			}
+			else if (known->second.changed) {
+				auto description = describe(b);
+
+				if (description.classname != known->second.classname || description.path != known->second.path)
+					different = true;
+				known->second = description;
+			}
+
+			known->second.pass = m_pass;
+			m_order.push_back(b);
+		}
+
+		for (auto i = m_boxes.begin(); i != m_boxes.end();) {
+			if (i->second.pass != m_pass) {
+				object_detach_byptr(m_owner, i->first);
+				removed(i->first, i->second.path);
+				i         = m_boxes.erase(i);
+				different = true;
+			}
+			else
+				++i;
+		}
+
+		m_stale = false;
+		if (different || m_order != m_previous)
+			++m_version;
+	}
+
+
+	/// Handle a notification received by the owner.
+	/// @param	sender	The object that sent it.
+	/// @param	message	The notification.
+	void notify(void* sender, c74::max::t_symbol* message) {
+		static const auto s_free      = c74::max::gensym("free");
+		static const auto s_will_free = c74::max::gensym("willfree");
+
+		auto known = m_boxes.find(static_cast<c74::max::t_object*>(sender));
+
+		if (known == m_boxes.end())
+			return;
+
+		// a freed box is forgotten at once, before another box can be made at the same address
+
+		if (message == s_free || message == s_will_free) {
+			removed(known->first, known->second.path);
+			m_boxes.erase(known);
+		}
+		else
+			known->second.changed = true;
+		m_stale = true;
+	}
+
+
+	/// The number of boxes.
+	size_t size() const {
+		return m_order.size();
+	}
+
+	/// The class name of every box, in the order of the patcher.
+	const c74::min::atoms& classnames() {
+		if (m_classnames_version != m_version) {
+			m_classnames.clear();
+			for (auto b : m_order)
+				m_classnames.push_back(c74::min::symbol {m_boxes[b].classname});
+			m_classnames_version = m_version;
+		}
+		return m_classnames;
+	}
+
+	/// The path of every box, in the order of the patcher.
+	const c74::min::atoms& paths() {
+		if (m_paths_version != m_version) {
+			m_paths.clear();
+			for (auto b : m_order)
+				m_paths.push_back(c74::min::symbol {m_boxes[b].path});
+			m_paths_version = m_version;
+		}
+		return m_paths;
+	}
+
+	/// Take the paths of the boxes that have been added and removed since the last time this was called.
+	/// A box that was added and removed in that time is in neither list.
+	void take_changes(c74::min::atoms& added, c74::min::atoms& removed) {
+		for (const auto& c : m_added)
+			added.push_back(c74::min::symbol {c.second});
+		for (const auto& c : m_removed)
+			removed.push_back(c74::min::symbol {c.second});
+		m_added.clear();
+		m_removed.clear();
+	}
+
+private:
+	struct box_info {
+		c74::max::t_symbol* classname;
+		c74::max::t_symbol* path;
+		uint64_t            pass { 0 };			///< the last update that found the box in the patcher
+		bool                changed { false };	///< the box has told us that it changed since it was described
+	};
+
+	using change = std::pair<c74::max::t_object*, c74::max::t_symbol*>;
+
+	c74::max::t_object*                                     m_owner { nullptr };
+	std::unordered_map<c74::max::t_object*, box_info>       m_boxes;
+	std::vector<c74::max::t_object*>                        m_order;			///< the boxes in the order of the patcher
+	std::vector<c74::max::t_object*>                        m_previous;		///< the order before the update, to compare with
+	bool                                                    m_stale { false };	///< a box has changed or gone since the last update
+	uint64_t                                                m_pass { 0 };
+	uint64_t                                                m_version { 0 };	///< changes whenever the boxes or their descriptions do
+	c74::min::atoms                                         m_classnames;
+	uint64_t                                                m_classnames_version { ~0ULL };
+	c74::min::atoms                                         m_paths;
+	uint64_t                                                m_paths_version { ~0ULL };
+	std::vector<change>                                     m_added;			///< since the last take_changes()
+	std::vector<change>                                     m_removed;
+
+	static box_info describe(c74::max::t_object* b) {
+		c74::min::box box {b};
+		return {box.classname(), box.path()};
+	}
+
+	void added(c74::max::t_object* b, c74::max::t_symbol* path) {
+		m_added.emplace_back(b, path);
+	}
+
+	void removed(c74::max::t_object* b, c74::max::t_symbol* path) {
+		auto a = std::find_if(m_added.begin(), m_added.end(), [b](const change& c) { return c.first == b; });
+
+		if (a != m_added.end())
+			m_added.erase(a);
+		else
+			m_removed.emplace_back(b, path);
+	}
+};
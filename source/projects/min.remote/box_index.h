@@ -0,0 +1,208 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2020 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#pragma once
+
+#include "c74_min_api.h"
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+
+/// The boxes of an object's patcher by scripting name, so that a message can find the box it is for without walking the patcher.
+///
+/// The index is built when it is first used and built again after the patcher changes.
+/// While it is built the owner is attached to the patcher and to each of its boxes,
+/// and must pass the notifications it receives on to notify().
+/// A name or pattern that finds no boxes also causes it to be built again, in case a box was added without a notification,
+/// but not more than once a second so that messages to a name that is not in the patcher stay cheap.
+
+class box_index {
+public:
+	using objects = std::vector<c74::max::t_object*>;
+
+	box_index() = default;
+
+	~box_index() {
+		detach();
+	}
+
+	box_index(const box_index&) = delete;
+	box_index& operator=(const box_index&) = delete;
+
+
+	/// Find the objects in the boxes with a scripting name.
+	/// @param	owner	The object whose patcher is searched.
+	/// @param	name	A scripting name, or a pattern in which * matches any characters and ? matches any one character.
+	/// @param	found	The objects in the matching boxes are added to this, in the order of the patcher.
+	/// @return			The generation of the index, which changes when the objects found may no longer be valid.
+	uint64_t find(c74::max::t_object* owner, c74::max::t_symbol* name, objects& found) {
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		auto fresh = !m_built;
+
+		m_owner = owner;
+		if (fresh)
+			build();
+
+		if (!lookup(name, found) && !fresh && c74::max::systimer_gettime() - m_built_at >= k_rescan_interval) {
+			build();
+			lookup(name, found);
+		}
+		return m_generation;
+	}
+
+
+	/// The generation of the index.
+	uint64_t generation() {
+		std::lock_guard<std::mutex> lock {m_mutex};
+		return m_generation;
+	}
+
+
+	/// Handle a notification received by the owner.
+	/// @param	sender		The object that sent it.
+	/// @param	message		The notification.
+	/// @param	attribute	For an attribute change, the name of the attribute.
+	void notify(void* sender, c74::max::t_symbol* message, c74::max::t_symbol* attribute) {
+		static const auto s_free          = c74::max::gensym("free");
+		static const auto s_will_free     = c74::max::gensym("willfree");
+		static const auto s_attr_modified = c74::max::gensym("attr_modified");
+		static const auto s_varname       = c74::max::gensym("varname");
+
+		std::lock_guard<std::mutex> lock {m_mutex};
+
+		if (!m_built)
+			return;
+
+		// anything the patcher says may be a box coming or going, but of a box's changes only its name matters
+
+		if (sender == m_patcher || message == s_free || message == s_will_free || (message == s_attr_modified && attribute == s_varname)) {
+			detach();
+			m_boxes.clear();
+			m_order.clear();
+			m_matches.clear();
+			m_built = false;
+			++m_generation;
+		}
+	}
+
+
+	/// True if a name contains wildcards.
+	static bool is_pattern(const char* name) {
+		for (; *name; ++name) {
+			if (*name == '*' || *name == '?')
+				return true;
+		}
+		return false;
+	}
+
+
+	/// Match a name against a pattern in which * matches any characters and ? matches any one character.
+	static bool matches(const char* pattern, const char* name) {
+		const char* star  = nullptr;
+		const char* retry = nullptr;
+
+		while (*name) {
+			if (*pattern == '*') {
+				star  = pattern++;
+				retry = name;
+			}
+			else if (*pattern == '?' || *pattern == *name) {
+				++pattern;
+				++name;
+			}
+			else if (star) {
+				pattern = star + 1;
+				name    = ++retry;
+			}
+			else
+				return false;
+		}
+		while (*pattern == '*')
+			++pattern;
+		return *pattern == 0;
+	}
+
+private:
+	c74::max::t_object*                                                   m_owner { nullptr };
+	c74::max::t_object*                                                   m_patcher { nullptr };
+	std::mutex                                                            m_mutex;
+	bool                                                                  m_built { false };
+	uint64_t                                                              m_generation { 0 };	///< counts the times the index was dropped
+	double                                                                m_built_at { 0.0 };	///< systimer time of the last build
+	std::unordered_map<c74::max::t_symbol*, c74::max::t_object*>          m_boxes;		///< the object in each named box
+	std::vector<std::pair<c74::max::t_symbol*, c74::max::t_object*>>      m_order;		///< the same, in the order of the patcher
+	std::unordered_map<c74::max::t_symbol*, objects>                      m_matches;	///< the objects matching each pattern used
+	objects                                                               m_attached;	///< the patcher and the boxes, to detach from
+
+	static constexpr double k_rescan_interval { 1000.0 };    ///< least ms between builds for lookups that find nothing
+
+	// Add the objects matching a name or pattern, returning false if there are none.
+	// The boxes that match a pattern are remembered until the index is dropped.
+
+	bool lookup(c74::max::t_symbol* name, objects& found) {
+		if (!is_pattern(name->s_name)) {
+			auto b = m_boxes.find(name);
+
+			if (b == m_boxes.end())
+				return false;
+			found.push_back(b->second);
+			return true;
+		}
+
+		auto m = m_matches.find(name);
+
+		if (m == m_matches.end()) {
+			objects matched;
+
+			for (const auto& b : m_order) {
+				if (matches(name->s_name, b.first->s_name))
+					matched.push_back(b.second);
+			}
+			m = m_matches.emplace(name, std::move(matched)).first;
+		}
+		found.insert(found.end(), m->second.begin(), m->second.end());
+		return !m->second.empty();
+	}
+
+	// walk the patcher, attaching to it and to every box so that renaming or removing a box is heard
+
+	void build() {
+		using namespace c74::max;
+
+		detach();
+		m_boxes.clear();
+		m_order.clear();
+		m_matches.clear();
+
+		m_patcher  = nullptr;
+		m_built_at = systimer_gettime();
+		object_obex_lookup(m_owner, gensym("#P"), &m_patcher);
+		if (!m_patcher)
+			return;
+
+		attach(m_patcher, gensym("nobox"));
+		for (auto b = jpatcher_get_firstobject(m_patcher); b; b = jbox_get_nextobject(b)) {
+			auto name = jbox_get_varname(b);
+
+			attach(b, gensym("box"));
+			if (name && name != gensym("") && m_boxes.emplace(name, jbox_get_object(b)).second)
+				m_order.emplace_back(name, jbox_get_object(b));
+		}
+		m_built = true;
+	}
+
+	void attach(c74::max::t_object* o, c74::max::t_symbol* name_space) {
+		if (c74::max::object_attach_byptr_register(m_owner, o, name_space) == c74::max::MAX_ERR_NONE)
+			m_attached.push_back(o);
+	}
+
+	void detach() {
+		for (auto o : m_attached)
+			c74::max::object_detach_byptr(m_owner, o);
+		m_attached.clear();
+	}
+};
@@ -4,6 +4,9 @@
 /// @license        Use of this source code is governed by the MIT License found in the License.md file.
 
 #include "c74_min.h"
+#include "box_index.h"
+#include <algorithm>
+#include <unordered_map>
 
 using namespace c74::min;
 
@@ -19,29 +22,172 @@ public:
     outlet<> m_out    { this, "(anything) query responses" };
 
 
+    attribute<bool> m_coalesce { this, "coalesce", false,
+        description {"Hold the messages of a batch until the next scheduler tick and deliver only the last message "
+                     "for each name and message name, so that values that are replaced within a tick are not sent. "
+                     "Messages sent without a batch are always delivered immediately."}
+    };
+
+
     message<> m_classnames { this, "anything",
         "Send a message to a named object. "
-        "First argument is the scripting name of the object. "
+        "First argument is the scripting name of the object, "
+        "or a pattern in which * matches any characters and ? matches any one character to send to every object with a matching name. "
         "Second argument is the name of the message to send. "
         "Any additional arguments are passed as arguments to the named object. ",
 
         MIN_FUNCTION {
-            auto p = patcher();
-            auto boxes = p.boxes();
-            atoms as {};
+            if (args.size() < 2)
+                return {};
 
-            for (auto& b : boxes) {
-                if (b.name() == args[0])
-                    b(args[1], args[2]);
-            }
-            //m_out.send(as);
+            send(args[0], args[1], static_cast<long>(args.size() - 2), args.data() + 2);
+            return {};
+        }
+    };
+
+
+    message<> m_batch { this, "batch",
+        "Send many messages to named objects at once. "
+        "The arguments are groups of the scripting name of an object (or a pattern), the name of the message, "
+        "the number of arguments to the message, and then those arguments, e.g. batch osc1 frequency 1 440. osc2 gain 1 0.5",
+
+        MIN_FUNCTION {
+            // each group is found just before it is sent, since an earlier message may have freed or renamed a box
+
+            auto valid = parse_batch(args, [&](symbol name, symbol selector, long argc, const atom* argv) {
+                if (m_coalesce)
+                    hold(name, selector, argc, argv);
+                else
+                    send(name, selector, argc, argv);
+            });
+
+            if (!valid)
+                cerr << "batch expects groups of a name, a message, an argument count, and the arguments" << endl;
+            return {};
+        }
+    };
+
+
+    message<> m_notify { this, "notify",
+        MIN_FUNCTION {
+            notification n { args };
+
+            m_index.notify(n.source(), n.name(), n.attr_name());
             return {};
         }
     };
 
 
 private:
+    box_index m_index;    ///< boxes by name, rather than walking the patcher for every message
+
+    // Call a function with each group of a batch.
+    // Returns false if the batch is malformed, in which case the groups before the error have been passed on.
+
+    template<class function>
+    static bool parse_batch(const atoms& args, function f) {
+        size_t i {0};
+
+        while (i < args.size()) {
+            if (args.size() - i < 3 || args[i].a_type != c74::max::A_SYM || args[i + 1].a_type != c74::max::A_SYM || args[i + 2].a_type != c74::max::A_LONG)
+                return false;
+
+            long argc = args[i + 2];
+
+            if (argc < 0 || static_cast<size_t>(argc) > args.size() - i - 3)
+                return false;
+            f(args[i], args[i + 1], argc, args.data() + i + 3);
+            i += 3 + argc;
+        }
+        return true;
+    }
+
+    static void send_to(c74::max::t_object* target, symbol selector, long argc, const atom* argv) {
+        auto av = const_cast<c74::max::t_atom*>(static_cast<const c74::max::t_atom*>(argv));
+        c74::max::object_method_typed(target, selector, argc, av, nullptr);
+    }
 
+    // Send a message to the boxes with a name.
+    // A message may free or rename a box, which drops the index, and the boxes that were found may then no longer exist,
+    // so they are found again before going on, leaving out the ones that have already been sent the message.
+
+    void send(symbol name, symbol selector, long argc, const atom* argv) {
+        box_index::objects targets;
+        box_index::objects sent;
+        auto               generation = m_index.find(maxobj(), name, targets);
+
+        for (size_t i = 0; i < targets.size(); ++i) {
+            if (m_index.generation() != generation) {
+                sent.insert(sent.end(), targets.begin(), targets.begin() + i);
+                targets.clear();
+                generation = m_index.find(maxobj(), name, targets);
+                targets.erase(std::remove_if(targets.begin(), targets.end(), [&sent](c74::max::t_object* o) {
+                    return std::find(sent.begin(), sent.end(), o) != sent.end();
+                }), targets.end());
+
+                i = 0;
+                if (targets.empty())
+                    break;
+            }
+            send_to(targets[i], selector, argc, argv);
+        }
+    }
+
+    // Coalesced messages wait for the next scheduler tick.
+    // A message replaces any waiting message with the same name and message name but keeps its place in the order.
+
+    struct held_message {
+        symbol name;
+        symbol selector;
+        atoms  args;
+    };
+
+    using held_key = std::pair<c74::max::t_symbol*, c74::max::t_symbol*>;
+
+    struct held_key_hash {
+        size_t operator()(const held_key& k) const {
+            return std::hash<c74::max::t_symbol*>()(k.first) * 31 + std::hash<c74::max::t_symbol*>()(k.second);
+        }
+    };
+
+    std::mutex                                           m_held_mutex;
+    std::vector<held_message>                            m_held;
+    std::unordered_map<held_key, size_t, held_key_hash>  m_held_index;    ///< where each name and message name is in m_held
+    std::vector<held_message>                            m_releasing;     ///< only used by m_release
+
+    void hold(symbol name, symbol selector, long argc, const atom* argv) {
+        std::lock_guard<std::mutex> lock {m_held_mutex};
+
+        auto slot = m_held_index.emplace(held_key {name, selector}, m_held.size());
+
+        if (slot.second)
+            m_held.push_back({name, selector, atoms(argv, argv + argc)});
+        else
+            m_held[slot.first->second].args.assign(argv, argv + argc);
+
+        if (m_held.size() == 1 && slot.second)
+            m_release.delay(0);
+    }
+
+    // delivers the held messages, which are taken out under the lock and sent after releasing it
+    // so that the objects receiving them can send new batches to us
+
+    timer<> m_release { this,
+        MIN_FUNCTION {
+            {
+                std::lock_guard<std::mutex> lock {m_held_mutex};
+
+                m_releasing.swap(m_held);
+                m_held.clear();
+                m_held_index.clear();
+            }
+
+            for (const auto& m : m_releasing)
+                send(m.name, m.selector, static_cast<long>(m.args.size()), m.args.data());
+            m_releasing.clear();
+            return {};
+        }
+    };
 };
 
 MIN_EXTERNAL(remote);
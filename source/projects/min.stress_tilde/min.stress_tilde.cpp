@@ -4,32 +4,315 @@
 ///	@license	Use of this source code is governed by the MIT License found in the License.md file.
 
 #include "c74_min.h"
+#include <algorithm>
+#include <cstdint>
+#include <random>
 
 using namespace c74::min;
 
 
+// Memory that the memory or the chase profile works through.
+// Only the buffer that the profile uses is allocated so that the working set is the size that was asked for.
+// It is allocated on the main thread and handed to the audio thread.
+
+struct working_set {
+    bool                       chained;    ///< made for the chase profile rather than the memory profile
+    std::vector<float>         samples;    ///< streamed through by the memory profile
+    std::vector<std::uint32_t> chain;      ///< a single random cycle through every entry, followed by the chase profile
+
+    working_set(size_t bytes, bool for_chase)
+    : chained {for_chase} {
+        if (!chained) {
+            samples.assign(std::max<size_t>(bytes / sizeof(float), 1), 0.0f);
+            return;
+        }
+
+        chain.resize(std::max<size_t>(bytes / sizeof(std::uint32_t), 2));
+
+        // Sattolo's algorithm shuffles the identity into one cycle that visits every entry,
+        // so following it jumps around the whole working set and defeats the prefetcher
+
+        std::mt19937 generator {std::random_device {}()};
+
+        for (std::uint32_t i = 0; i < chain.size(); ++i)
+            chain[i] = i;
+        for (auto i = chain.size() - 1; i > 0; --i) {
+            std::uniform_int_distribution<size_t> pick {0, i - 1};
+            std::swap(chain[i], chain[pick(generator)]);
+        }
+    }
+};
+
+
 class stress : public object<stress>, public vector_operator<> {
 public:
     MIN_DESCRIPTION	{ "Eat up a specified percentage of processor time to stress the computer." };
     MIN_TAGS		{ "benchmarking" };
     MIN_AUTHOR		{ "Timothy Place, Rob Sussman" };
 
+    outlet<> stats_out	{ this, "(list) since the last report: mean load, peak load, overruns, and units of work done" };
+
+    ~stress() {
+        delete m_pending.exchange(nullptr);
+        collect_retired();
+    }
+
+private:
+    // these must be declared before the attributes whose setters use them
+    // The working set is owned by the audio thread.
+    // New sets are handed over through m_pending and replaced sets are handed back through m_retired
+    // so that allocation and deallocation only ever happen on the main thread.
+
+    std::unique_ptr<working_set> m_set;
+    std::atomic<working_set*>    m_pending { nullptr };
+    fifo<working_set*>           m_retired { 16 };
+
+    // the attributes have not changed yet when their setters are called so the allocation is deferred until they have
+
+    queue<> m_prepare { this,
+        MIN_FUNCTION {
+            prepare();
+            return {};
+        }
+    };
+
+public:
     attribute<number, threadsafe::yes, limit::clamp> target { this, "target", 0.0,
         range {0.0, 100.0},
         description {"Percentage of the CPU to burn."}
     };
 
+    enum class profiles : int { spin, compute, memory, chase, spike, enum_count };
+
+    enum_map profiles_range = {"spin", "compute", "memory", "chase", "spike"};
+
+    attribute<profiles> profile { this, "profile", profiles::spin, profiles_range,
+        description {"How the CPU is kept busy. "
+                     "'spin' only reads the clock. "
+                     "'compute' runs multiply-add chains like a filter bank. "
+                     "'memory' streams through the working set like a long delay line. "
+                     "'chase' follows a random chain through the working set so that nearly every read misses the cache. "
+                     "'spike' spins at the target and periodically burns the spike percentage for one vector."},
+        setter { MIN_FUNCTION {
+            m_prepare();
+            return args;
+        }}
+    };
+
+    attribute<int, threadsafe::no, limit::clamp> working_set_size { this, "working_set", 8192,
+        range {4, 1048576},
+        title {"Working Set"},
+        description {"Size in kilobytes of the memory used by the memory and chase profiles. "
+                     "Sizes larger than the processor's caches measure main memory."},
+        setter { MIN_FUNCTION {
+            m_prepare();
+            return args;
+        }}
+    };
+
+    attribute<number, threadsafe::yes, limit::clamp> spike { this, "spike", 150.0,
+        range {0.0, 1000.0},
+        description {"Percentage of the vector time burned by each spike of the spike profile. "
+                     "Values over 100 cause an overrun."}
+    };
+
+    attribute<number, threadsafe::yes, limit::clamp> spike_interval { this, "spike_interval", 1000.0,
+        range {1.0, 60000.0},
+        title {"Spike Interval"},
+        description {"Time in milliseconds between the spikes of the spike profile."}
+    };
+
+    message<> bang { this, "bang", "Report the achieved load and the overruns since the last report.",
+        MIN_FUNCTION {
+            auto busy     = m_busy.exchange(0);
+            auto budget   = m_budget.exchange(0);
+            auto peak     = m_peak.exchange(0);
+            auto overruns = m_overruns.exchange(0);
+            auto work     = m_work.exchange(0);
+
+            collect_retired();
+            stats_out.send(budget ? 100.0 * busy / budget : 0.0, peak / 10.0, static_cast<long>(overruns), static_cast<double>(work));
+            return {};
+        }
+    };
+
     void operator()(audio_bundle input, audio_bundle output) {
-        auto   svtime_ms {vector_size() / samplerate() * 1000.0};
-        auto   spintime {svtime_ms * target / 100.0};
-        auto   intime {c74::max::systimer_gettime()};
-        auto   outtime {intime + spintime};
-        size_t spincount {};
+        auto svtime_ms {vector_size() / samplerate() * 1000.0};
+        auto percent {target.get()};
+        auto intime {c74::max::systimer_gettime()};
+
+        take_pending();
+
+        auto chosen = profile.get();
+
+        if (chosen == profiles::spike) {
+            m_since_spike += svtime_ms;
+            if (m_since_spike >= spike_interval) {
+                m_since_spike = 0.0;
+                percent       = spike;
+            }
+        }
+        if ((chosen == profiles::memory || chosen == profiles::chase) && (!m_set || m_set->chained != (chosen == profiles::chase)))
+            chosen = profiles::spin;    // the working set for this profile has not arrived yet
+
+        auto outtime {intime + svtime_ms * percent / 100.0};
+
+        std::uint64_t work {};
+
+        switch (chosen) {
+            case profiles::compute:
+                work = compute(outtime);
+                break;
+            case profiles::memory:
+                work = stream(outtime);
+                break;
+            case profiles::chase:
+                work = chase(outtime);
+                break;
+            case profiles::spin:
+            case profiles::spike:
+            case profiles::enum_count:
+                while (c74::max::systimer_gettime() < outtime)
+                    ++work;
+                break;
+        }
+
+        // report in microseconds so the statistics can be accumulated in atomic integers
+
+        auto elapsed = c74::max::systimer_gettime() - intime;
+        auto load    = static_cast<std::uint64_t>(1000.0 * elapsed / svtime_ms);    // tenths of a percent
+        auto peak    = m_peak.load(std::memory_order_relaxed);
 
-        while (c74::max::systimer_gettime() < outtime)
-            ++spincount;
+        m_busy += static_cast<std::uint64_t>(elapsed * 1000.0);
+        m_budget += static_cast<std::uint64_t>(svtime_ms * 1000.0);
+        m_work += work;
+        if (elapsed > svtime_ms)
+            ++m_overruns;
+        while (load > peak && !m_peak.compare_exchange_weak(peak, load))
+            ;
     }
 
+private:
+    std::atomic<std::uint64_t> m_busy { 0 };        ///< microseconds spent in the perform routine
+    std::atomic<std::uint64_t> m_budget { 0 };      ///< microseconds of audio processed
+    std::atomic<std::uint64_t> m_peak { 0 };        ///< highest load of a single vector in tenths of a percent
+    std::atomic<std::uint64_t> m_overruns { 0 };    ///< vectors that took longer than their own duration
+    std::atomic<std::uint64_t> m_work { 0 };        ///< profile-specific units of work: loop iterations, samples, or reads
+
+    double m_since_spike { 0.0 };
+    size_t m_position { 0 };           ///< where the memory profile resumes in the working set
+    float  m_accumulators[16] {};      ///< state of the compute profile's multiply-add chains
+    float  m_sink { 0.0f };            ///< keeps the results of the work alive so it is not optimized away
+
+    static constexpr size_t k_chunk { 1024 };    ///< units of work between checks of the clock
+
+    // the last working set handed to the audio thread, which only the main thread uses
+
+    size_t m_handed_bytes { 0 };
+    bool   m_handed_chained { false };
+
+
+    // Allocate a new working set if the profile needs one.
+    // Called on the main thread.
+
+    void prepare() {
+        auto bytes = static_cast<size_t>(working_set_size.get()) * 1024;
+
+        collect_retired();
+        if (profile != profiles::memory && profile != profiles::chase)
+            return;
+
+        // m_set belongs to the audio thread, so we compare with what we last handed over instead
+
+        auto chained = (profile == profiles::chase);
+
+        if (m_handed_bytes == bytes && m_handed_chained == chained)
+            return;
+        m_handed_bytes   = bytes;
+        m_handed_chained = chained;
+
+        // if a set is still waiting to be picked up by the audio thread then it was never used and we can free it
+        delete m_pending.exchange(new working_set {bytes, chained});
+    }
+
+
+    void collect_retired() {
+        working_set* retired;
+        while (m_retired.try_dequeue(retired))
+            delete retired;
+    }
+
+
+    // Replace the working set with the pending one.
+    // Called on the audio thread.
+
+    void take_pending() {
+        if (!m_pending.load())
+            return;
+        if (!m_retired.try_enqueue(m_set.get()))
+            return;    // the main thread has fallen behind collecting sets, try again on the next vector
+
+        // only this thread removes a pending set so it cannot have disappeared since we checked
+        m_set.release();
+        m_set.reset(m_pending.exchange(nullptr));
+        m_position = 0;
+    }
+
+
+    // Independent multiply-add chains keep the floating-point units busy without touching memory.
+
+    std::uint64_t compute(double outtime) {
+        std::uint64_t work {};
+
+        while (c74::max::systimer_gettime() < outtime) {
+            for (size_t i = 0; i < k_chunk; ++i) {
+                for (auto& a : m_accumulators)
+                    a = a * 0.999999f + 0.000001f;
+            }
+            work += k_chunk;
+        }
+
+        m_sink += m_accumulators[0];
+        return work;
+    }
+
+
+    // Read and write every sample of the working set in order, resuming where the last vector left off.
+
+    std::uint64_t stream(double outtime) {
+        auto&         samples = m_set->samples;
+        std::uint64_t work {};
+
+        while (c74::max::systimer_gettime() < outtime) {
+            auto end = std::min(m_position + k_chunk * 16, samples.size());
+
+            for (auto i = m_position; i < end; ++i)
+                samples[i] = samples[i] * 0.5f + 1.0f;
+            work += end - m_position;
+            m_position = (end == samples.size()) ? 0 : end;
+        }
+
+        m_sink += samples[0];
+        return work;
+    }
+
+
+    // Each read depends on the one before so the processor has to wait for every cache miss.
+
+    std::uint64_t chase(double outtime) {
+        const auto&   chain = m_set->chain;
+        auto          index = static_cast<std::uint32_t>(m_position % chain.size());
+        std::uint64_t work {};
+
+        while (c74::max::systimer_gettime() < outtime) {
+            for (size_t i = 0; i < k_chunk; ++i)
+                index = chain[index];
+            work += k_chunk;
+        }
+
+        m_position = index;
+        return work;
+    }
 };
 
 MIN_EXTERNAL(stress);
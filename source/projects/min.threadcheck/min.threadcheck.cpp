@@ -4,6 +4,8 @@
 ///	@license	Use of this source code is governed by the MIT License found in the License.md file.
 
 #include "c74_min.h"
+#include "../shared/latency_histogram.h"
+#include <array>
 
 using namespace c74::min;
 
@@ -16,28 +18,120 @@ public:
     MIN_RELATED		{ "dspstress~" };
 
     inlet<>  input			{ this, "(anything) message to check" };
+    inlet<>  report_in		{ this, "(bang) report the latency statistics" };
     outlet<> outlet_main	{ this, "(bang) message received on main thread" };
     outlet<> outlet_sched	{ this, "(bang) message received on scheduler thread" };
     outlet<> outlet_audio	{ this, "(bang) message received on audio thread" };
     outlet<> outlet_other	{ this, "(bang) message received on unknown thread" };
+    outlet<> outlet_stats	{ this, "(list) latency statistics: thread, count, p50, p99, p99.9, and max in ms" };
+
+    attribute<bool> profile { this, "profile", false,
+        description {"Record how late each stamp message is. "
+                     "Other messages have no time to measure from and are not recorded."}
+    };
 
     c74::min::function check = MIN_FUNCTION {
-        // check scheduler last because it might be running in main or audio threads depending on settings
-        if (c74::max::systhread_ismainthread())
-            outlet_main.send(k_sym_bang);
-        else if (c74::max::systhread_isaudiothread())
-            outlet_audio.send(k_sym_bang);
-        else if (c74::max::systhread_istimerthread())
-            outlet_sched.send(k_sym_bang);
-        else
-            outlet_other.send(k_sym_bang);
+        report_thread(current_thread());
         return {};
     };
 
     message<threadsafe::yes> list { this, "list", "Message to check.", check };
     message<threadsafe::yes> anything { this, "anything", "Message to check.", check };
     message<threadsafe::yes> number { this, "number", "Message to check.", check };
-    message<threadsafe::yes> bang { this, "bang", "Message to check.", check };
+
+    message<threadsafe::yes> stamp { this, "stamp",
+        "Message to check that also measures how late it is when profiling. "
+        "The argument is the time in ms at which the message was sent, from cpuclock.",
+        MIN_FUNCTION {
+            auto thread = current_thread();
+
+            if (profile && !args.empty())
+                measure(thread, args[0]);
+            report_thread(thread);
+            return {};
+        }
+    };
+
+    message<threadsafe::yes> bang { this, "bang", "Message to check. In the right inlet, report the latency statistics.",
+        MIN_FUNCTION {
+            if (inlet == 1)
+                report();
+            else
+                check(args, inlet);
+            return {};
+        }
+    };
+
+    message<> clear { this, "clear", "Forget the recorded latencies.",
+        MIN_FUNCTION {
+            for (auto& histogram : m_histograms)
+                histogram.clear();
+            return {};
+        }
+    };
+
+private:
+    enum class threads : int { main, scheduler, audio, other, enum_count };
+
+    // Each thread records into its own histogram so the threads never contend for the same counters.
+    // (Messages from unknown threads may share theirs, which is still safe because recording is atomic.)
+
+    std::array<latency_histogram, static_cast<size_t>(threads::enum_count)> m_histograms;
+
+    static threads current_thread() {
+        // check scheduler last because it might be running in main or audio threads depending on settings
+        if (c74::max::systhread_ismainthread())
+            return threads::main;
+        else if (c74::max::systhread_isaudiothread())
+            return threads::audio;
+        else if (c74::max::systhread_istimerthread())
+            return threads::scheduler;
+        else
+            return threads::other;
+    }
+
+    void report_thread(threads thread) {
+        switch (thread) {
+            case threads::main:
+                outlet_main.send(k_sym_bang);
+                break;
+            case threads::scheduler:
+                outlet_sched.send(k_sym_bang);
+                break;
+            case threads::audio:
+                outlet_audio.send(k_sym_bang);
+                break;
+            case threads::other:
+            case threads::enum_count:
+                outlet_other.send(k_sym_bang);
+                break;
+        }
+    }
+
+    // cpuclock reads the same clock as systimer_gettime(), so the stamp and the time now can be compared
+
+    void measure(threads thread, double then) {
+        double now     = c74::max::systimer_gettime();
+        auto   latency = std::max(now - then, 0.0) * 1000.0;
+        m_histograms[static_cast<size_t>(thread)].record(static_cast<std::uint64_t>(latency));
+    }
+
+    void report() {
+        static const symbol names[] = {"main", "scheduler", "audio", "other"};
+
+        for (auto i = 0; i < static_cast<int>(threads::enum_count); ++i) {
+            const auto& histogram = m_histograms[i];
+
+            if (histogram.count() == 0)
+                continue;
+            outlet_stats.send(names[i],
+                static_cast<long>(histogram.count()),
+                histogram.percentile(50.0) / 1000.0,
+                histogram.percentile(99.0) / 1000.0,
+                histogram.percentile(99.9) / 1000.0,
+                histogram.max() / 1000.0);
+        }
+    }
 };
 
 MIN_EXTERNAL(threadcheck);
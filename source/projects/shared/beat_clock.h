@@ -0,0 +1,144 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2018 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#pragma once
+
+#include "c74_min_api.h"
+
+using namespace c74::min;
+
+
+#ifdef MAC_VERSION
+#pragma mark -
+#pragma mark Absolute Schedule
+#endif
+
+
+/// Calculates timer delays against absolute target times rather than relative to when the timer fired.
+/// Re-arming a timer with the interval from inside its callback adds the scheduler's lateness to every beat,
+/// whereas scheduling the next beat at `previous_target + interval` keeps the lateness from accumulating.
+
+class absolute_schedule {
+public:
+	/// Begin a new sequence of beats with the beat that fires next.
+	/// This is called from the main thread while the timer may still be running,
+	/// so it only raises a flag and the timer thread moves the target at its next advance().
+	void start() {
+		m_restart = true;
+	}
+
+	/// Advance to the next beat. Only called from the timer thread.
+	/// @param	interval	The time in milliseconds from the current beat to the next one.
+	///	@return				The delay in milliseconds from now until the next beat should fire.
+	double advance(double interval) {
+		auto now = c74::max::systimer_gettime();
+
+		if (m_restart.exchange(false))
+			m_target = now;
+		m_target += interval;
+
+		// If we fell more than a full interval behind (e.g. the scheduler was blocked)
+		// we re-align with the present rather than firing a burst of beats to catch up.
+
+		if (m_target < now)
+			m_target = now;
+		return m_target - now;
+	}
+
+private:
+	std::atomic<bool> m_restart { true };
+	double            m_target {};    ///< only used by the timer thread
+};
+
+
+#ifdef MAC_VERSION
+#pragma mark -
+#pragma mark Click Generator
+#endif
+
+
+/// Renders a click (a single sample of 1.0) at the exact sample offset of each beat.
+///
+/// The scheduler thread reports the interval to the next beat each time a beat fires.
+/// The audio thread counts samples against those intervals, so the clicks stay phase-locked to the audio clock
+/// even when the scheduler (and thus the reporting of the intervals) runs late.
+
+class click_generator {
+public:
+	/// Called from the scheduler when a beat fires.
+	/// @param	interval	The time in milliseconds until the next beat.
+	void beat(double interval) {
+		m_running = true;
+		m_intervals.try_enqueue(interval);
+	}
+
+	/// Called when the beats stop. Any pending intervals are discarded by the audio thread.
+	void stop() {
+		m_running = false;
+	}
+
+	/// Called when audio starts.
+	/// The beats go on while audio is off, so the intervals they reported since then are stale and are discarded by the audio thread.
+	void restart() {
+		m_restart = true;
+	}
+
+	/// Called from the audio thread to render a vector of clicks.
+	void operator()(sample* output, long frame_count, double samplerate) {
+		auto   samples_per_ms = samplerate / 1000.0;
+		double interval;
+
+		if (m_restart.exchange(false) || !m_running) {
+			while (m_intervals.try_dequeue(interval))
+				;
+			m_state = states::idle;
+		}
+
+		for (auto i = 0; i < frame_count; ++i) {
+			output[i] = 0.0;
+
+			switch (m_state) {
+				case states::idle:
+					if (m_intervals.try_dequeue(interval)) {
+						output[i]   = 1.0;
+						m_remaining = interval * samples_per_ms;
+						m_state     = states::counting;
+					}
+					break;
+				case states::counting:
+					m_remaining -= 1.0;
+					if (m_remaining <= 0.0) {
+						output[i] = 1.0;
+						m_state   = states::waiting;
+					}
+					break;
+				case states::waiting:    // the beat has sounded but the scheduler has not yet reported the following interval
+					if (m_intervals.try_dequeue(interval)) {
+						m_remaining += interval * samples_per_ms - 1.0;
+						m_state = states::counting;
+
+						// the interval arrived so late that the next beat is already due
+
+						if (m_remaining <= 0.0) {
+							output[i] = 1.0;
+							m_state   = states::waiting;
+						}
+					}
+					else
+						m_remaining -= 1.0;
+					break;
+			}
+		}
+	}
+
+private:
+	enum class states { idle, counting, waiting };
+
+	fifo<double>      m_intervals { 64 };
+	std::atomic<bool> m_running { false };
+	std::atomic<bool> m_restart { false };
+	states            m_state { states::idle };
+	double            m_remaining {};    ///< samples until the next click, negative while waiting for a late interval
+};
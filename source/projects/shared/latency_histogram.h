@@ -0,0 +1,121 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2018 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+
+/// A histogram of latencies in the style of HdrHistogram.
+///
+/// Values are recorded in microseconds into buckets whose width grows with the value,
+/// so that every value is stored with a precision of better than 2% (a bucket is at most 1/64 of its value wide) using a small, fixed amount of memory.
+/// Recording is lock-free and wait-free: it is a single atomic increment, so it may be done from the audio thread.
+/// Reading the percentiles while values are being recorded is safe but may miss the most recent values.
+
+class latency_histogram {
+public:
+	latency_histogram()
+	: m_counts(k_bucket_count) {}
+
+	latency_histogram(const latency_histogram&) = delete;
+	latency_histogram& operator=(const latency_histogram&) = delete;
+
+	/// Record one latency.
+	/// @param	microseconds	The latency. Values beyond the range of the histogram are recorded in the last bucket.
+	void record(std::uint64_t microseconds) {
+		m_counts[index_of(microseconds)].fetch_add(1, std::memory_order_relaxed);
+		m_total.fetch_add(1, std::memory_order_relaxed);
+
+		auto max = m_max.load(std::memory_order_relaxed);
+		while (microseconds > max && !m_max.compare_exchange_weak(max, microseconds, std::memory_order_relaxed))
+			;
+	}
+
+	/// Forget all of the recorded values.
+	void clear() {
+		for (auto& count : m_counts)
+			count.store(0, std::memory_order_relaxed);
+		m_total.store(0, std::memory_order_relaxed);
+		m_max.store(0, std::memory_order_relaxed);
+	}
+
+	/// The number of values recorded.
+	std::uint64_t count() const {
+		return m_total.load(std::memory_order_relaxed);
+	}
+
+	/// The largest value recorded, exactly.
+	std::uint64_t max() const {
+		return m_max.load(std::memory_order_relaxed);
+	}
+
+	/// The value at a percentile.
+	/// @param	percentile	The percentile in the range [0, 100].
+	/// @return				The largest value that is equivalent, within the precision of the histogram,
+	///						to the value below which the given percentage of the recorded values fall.
+	std::uint64_t percentile(double percentile) const {
+		std::uint64_t total {};
+		for (const auto& count : m_counts)
+			total += count.load(std::memory_order_relaxed);
+		if (total == 0)
+			return 0;
+
+		auto target = static_cast<std::uint64_t>(percentile / 100.0 * total + 0.5);
+		if (target < 1)
+			target = 1;
+
+		std::uint64_t cumulative {};
+		for (std::size_t i = 0; i < m_counts.size(); ++i) {
+			cumulative += m_counts[i].load(std::memory_order_relaxed);
+			if (cumulative >= target)
+				return std::min(highest_equivalent_value(i), max());
+		}
+		return max();
+	}
+
+private:
+	// Values below k_linear_count each have their own bucket.
+	// Above that each power of two is divided into k_linear_count / 2 buckets, keeping 7 significant bits of the value.
+
+	static constexpr int           k_sub_bucket_bits	{ 7 };
+	static constexpr std::uint64_t k_linear_count		{ 1 << k_sub_bucket_bits };
+	static constexpr std::uint64_t k_half_count			{ k_linear_count / 2 };
+	static constexpr int           k_max_bits			{ 36 };    ///< about 19 hours in microseconds
+	static constexpr std::size_t   k_bucket_count		{ k_half_count * (k_max_bits - k_sub_bucket_bits + 1) + k_linear_count };
+
+	std::vector<std::atomic<std::uint64_t>> m_counts;
+	std::atomic<std::uint64_t>              m_total { 0 };
+	std::atomic<std::uint64_t>              m_max { 0 };
+
+	static int most_significant_bit(std::uint64_t value) {
+		auto bit = 0;
+		while (value >>= 1)
+			++bit;
+		return bit;
+	}
+
+	static std::size_t index_of(std::uint64_t value) {
+		if (value < k_linear_count)
+			return static_cast<std::size_t>(value);
+
+		auto shift = most_significant_bit(value) - (k_sub_bucket_bits - 1);
+		if (shift > k_max_bits - k_sub_bucket_bits + 1)
+			return k_bucket_count - 1;
+		return static_cast<std::size_t>(k_half_count * shift + (value >> shift));
+	}
+
+	static std::uint64_t highest_equivalent_value(std::size_t index) {
+		if (index < k_linear_count)
+			return index;
+
+		auto shift = index / k_half_count - 1;
+		auto lower = (index % k_half_count + k_half_count) << shift;
+		return lower + (std::uint64_t {1} << shift) - 1;
+	}
+};
@@ -0,0 +1,91 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2018 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#pragma once
+
+#include "c74_min_api.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+using namespace c74::min;
+
+
+/// Measures the peak and RMS level of each vector of audio and smooths them with attack and release ballistics.
+///
+/// The detector is run on the audio thread once per vector.
+/// The smoothed levels may be read from any thread.
+
+class level_detector {
+public:
+	/// Measure one vector of audio.
+	/// @param	input		The samples.
+	/// @param	frame_count	The number of samples.
+	/// @param	samplerate	The sample rate.
+	/// @param	attack		Time in ms for the levels to rise.
+	/// @param	release		Time in ms for the levels to fall.
+	void operator()(const sample* input, long frame_count, double samplerate, double attack, double release) {
+		if (frame_count <= 0)
+			return;
+
+		double peak, rms;
+		measure(input, frame_count, peak, rms);
+
+		auto vector_ms     = frame_count / samplerate * 1000.0;
+		auto attack_coeff  = coefficient(vector_ms, attack);
+		auto release_coeff = coefficient(vector_ms, release);
+
+		m_peak_envelope = follow(m_peak_envelope, peak, attack_coeff, release_coeff);
+		m_rms_envelope  = follow(m_rms_envelope, rms, attack_coeff, release_coeff);
+		m_peak.store(m_peak_envelope, std::memory_order_relaxed);
+		m_rms.store(m_rms_envelope, std::memory_order_relaxed);
+	}
+
+	/// The smoothed peak amplitude.
+	double peak() const {
+		return m_peak.load(std::memory_order_relaxed);
+	}
+
+	/// The smoothed RMS amplitude.
+	double rms() const {
+		return m_rms.load(std::memory_order_relaxed);
+	}
+
+
+	/// Find the peak and RMS amplitude of a vector in a single pass.
+	/// The loop has no branches so that the compiler can vectorize it.
+	static void measure(const sample* input, long frame_count, double& peak, double& rms) {
+		sample highest {};
+		sample sum {};
+
+		for (auto i = 0; i < frame_count; ++i) {
+			auto x  = input[i];
+			highest = std::max(highest, std::abs(x));
+			sum += x * x;
+		}
+		peak = highest;
+		rms  = std::sqrt(sum / frame_count);
+	}
+
+	/// The one-pole coefficient that moves a level most of the way (1 - 1/e) to its target in the given time
+	/// when it is updated once per vector.
+	static double coefficient(double vector_ms, double time_ms) {
+		return time_ms <= 0.0 ? 1.0 : 1.0 - std::exp(-vector_ms / time_ms);
+	}
+
+	/// Move an envelope towards a level.
+	static double follow(double envelope, double level, double attack_coeff, double release_coeff) {
+		envelope += (level - envelope) * (level > envelope ? attack_coeff : release_coeff);
+		return envelope < k_silence ? 0.0 : envelope;    // stop decaying before the envelope becomes denormal
+	}
+
+private:
+	static constexpr double k_silence { 1e-10 };
+
+	double              m_peak_envelope {};
+	double              m_rms_envelope {};
+	std::atomic<double> m_peak { 0.0 };
+	std::atomic<double> m_rms { 0.0 };
+};
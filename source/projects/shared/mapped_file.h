@@ -0,0 +1,155 @@
+/// @file
+///	@ingroup 	minexamples
+///	@copyright	Copyright 2018 The Min-DevKit Authors. All rights reserved.
+///	@license	Use of this source code is governed by the MIT License found in the License.md file.
+
+#pragma once
+
+#include "c74_min_api.h"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#ifdef WIN_VERSION
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+/// What the file system knows about a file's contents without reading it.
+/// Two equal statuses for the same file almost certainly mean the contents have not changed.
+
+struct file_status {
+	std::int64_t  modified {-1};    ///< modification time in nanoseconds, or -1 if the file does not exist
+	std::uint64_t size {};
+
+	bool exists() const {
+		return modified != -1;
+	}
+
+	bool operator==(const file_status& other) const {
+		return modified == other.modified && size == other.size;
+	}
+
+	bool operator!=(const file_status& other) const {
+		return !(*this == other);
+	}
+
+	static file_status of(const std::string& filename) {
+		file_status status;
+#ifdef WIN_VERSION
+		WIN32_FILE_ATTRIBUTE_DATA info;
+		if (GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &info)) {
+			ULARGE_INTEGER time;
+			time.LowPart    = info.ftLastWriteTime.dwLowDateTime;
+			time.HighPart   = info.ftLastWriteTime.dwHighDateTime;
+			status.modified = static_cast<std::int64_t>(time.QuadPart) * 100;    // FILETIME counts 100 ns intervals
+			status.size     = (static_cast<std::uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+		}
+#else
+		struct stat info;
+		if (stat(filename.c_str(), &info) == 0) {
+#ifdef MAC_VERSION
+			auto nanoseconds = info.st_mtimespec.tv_nsec;
+#else
+			auto nanoseconds = info.st_mtim.tv_nsec;
+#endif
+			status.modified = static_cast<std::int64_t>(info.st_mtime) * 1000000000 + nanoseconds;
+			status.size     = static_cast<std::uint64_t>(info.st_size);
+		}
+#endif
+		return status;
+	}
+};
+
+
+/// A read-only memory-mapping of a file.
+
+class mapped_file {
+public:
+	explicit mapped_file(const std::string& filename) {
+#ifdef WIN_VERSION
+		m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("could not open " + filename);
+
+		LARGE_INTEGER size;
+		GetFileSizeEx(m_file, &size);
+		m_size = static_cast<size_t>(size.QuadPart);
+		if (m_size) {
+			m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (m_mapping)
+				m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+			if (!m_data) {
+				close();
+				throw std::runtime_error("could not map " + filename);
+			}
+		}
+#else
+		m_file = ::open(filename.c_str(), O_RDONLY);
+		if (m_file < 0)
+			throw std::runtime_error("could not open " + filename);
+
+		struct stat info;
+		fstat(m_file, &info);
+		m_size = static_cast<size_t>(info.st_size);
+		if (m_size) {
+			auto data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+			if (data == MAP_FAILED) {
+				close();
+				throw std::runtime_error("could not map " + filename);
+			}
+			m_data = static_cast<const char*>(data);
+		}
+#endif
+	}
+
+	~mapped_file() {
+		close();
+	}
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	const char* data() const {
+		return m_data;
+	}
+
+	size_t size() const {
+		return m_size;
+	}
+
+private:
+	const char* m_data {};
+	size_t      m_size {};
+#ifdef WIN_VERSION
+	HANDLE m_file {INVALID_HANDLE_VALUE};
+	HANDLE m_mapping {};
+#else
+	int m_file {-1};
+#endif
+
+	void close() {
+#ifdef WIN_VERSION
+		if (m_data)
+			UnmapViewOfFile(m_data);
+		if (m_mapping)
+			CloseHandle(m_mapping);
+		if (m_file != INVALID_HANDLE_VALUE)
+			CloseHandle(m_file);
+		m_mapping = nullptr;
+		m_file    = INVALID_HANDLE_VALUE;
+#else
+		if (m_data)
+			munmap(const_cast<char*>(m_data), m_size);
+		if (m_file >= 0)
+			::close(m_file);
+		m_file = -1;
+#endif
+		m_data = nullptr;
+	}
+};